@@ -11,26 +11,34 @@
 \******************************************************************************/
 
 #include <assert.h>
+#include <cmath>
 #include <iostream>
 #include <fstream>
+#include <iomanip>
+#include <sstream>
 #include <algorithm>
+#include <map>
 #include <highgui.h>
+#include <boost/scoped_array.hpp>
+#include <boost/shared_ptr.hpp>
 #include "analysis_tools.h"
 #include "options.h"
 #include "image_region_list.h"
 #include "io.h"
+#include "image_cache.h"
+#include "match_dump.h"
+#include "metrics.h"
 #include "progress_bar.h"
+#include "parallel.h"
 
 namespace fs = boost::filesystem;
 namespace at = analysis_tools;
 
-// TODO add options for polygons, ellipses and circles for label types
 // TODO implement labels (give them a use)
 //   TODO add option to ignore labels
 // TODO draw a line to the nearest match in DrawResults
 // TODO add filtering by score and color score
 //   TODO may want to change name of score as its same as color score
-// TODO output results
 // TODO Implement having a second score value
 
 // simple structure containing an index and a score
@@ -38,25 +46,113 @@ struct IndexScore
 {
   IndexScore() {}
   IndexScore(size_t i, double s) : index(i), score(s) {}
-  IndexScore(const IndexScore& a) : index(a.index), score(a.score) {}
   
   size_t index;
   double score;
 };
 
+// geometry of one region prepared for the matching loop so every region is
+// only converted once per image instead of once per compared pair
+struct RegionGeometry
+{
+  at::Rect                box;      // bounding box
+  bool                    is_rect;  // true if box is the region itself
+  bool                    is_ellipse;
+  at::Ellipse             ellipse;  // shape of an ellipse or circle
+  bool                    is_mask;
+  at::RLE                 mask;     // runs of a mask (refers to the region
+                                    // list, not copied)
+  std::vector<at::Point>  outline;  // outline (corners for rectangles, empty
+                                    // for ellipses)
+};
+
+// scratch space used by one matching thread, reused for every image
+struct MatchScratch
+{
+  std::vector<RegionGeometry> true_geometry;
+  std::vector< boost::shared_ptr<at::PreparedPolygon> > true_polygons;
+  std::vector<RegionGeometry> computed_geometry;
+  std::vector<at::Rect>       true_boxes;
+  at::RectIndex               true_index;
+  std::vector<int>            candidates;
+  at::ScoreContext            context;
+  std::vector<int>            true_labels;   // label index of each truth
+  std::vector<LocalizationHistogram> localization;  // one per label
+};
+
+// matches the regions of a single image, used with ParallelFor() by
+// DetermineMatches().  Each image only writes to its own entry of top_matches
+// so images can be processed in parallel without locking.  Pairs scoring
+// above overlap_threshold are also added to the localization histograms of
+// the calling thread.  When compare_roi_list is not empty its regions are
+// matched against the same prepared ground truth into compare_matches.
+struct MatchImage
+{
+  MatchImage(
+    const std::vector<ImageRegionList>&                     true_roi_list,
+    const std::vector<ImageRegionList>&                     computed_roi_list,
+    const std::vector<ImageRegionList>&                     compare_roi_list,
+    double                                                  overlap_threshold,
+    const std::map<std::string, int>&                       label_index,
+    std::vector< std::vector< std::vector<IndexScore> > >&  top_matches,
+    std::vector< std::vector< std::vector<IndexScore> > >&  compare_matches,
+    MatchScratch*                                           scratch,
+    ProgressBar&                                            progress ) :
+    true_roi_list(true_roi_list), computed_roi_list(computed_roi_list),
+    compare_roi_list(compare_roi_list), overlap_threshold(overlap_threshold),
+    label_index(label_index), top_matches(top_matches),
+    compare_matches(compare_matches), scratch(scratch), progress(progress) {}
+
+  void operator()( size_t image_index, int thread );
+
+  // matches one computed region list against the prepared ground truth
+  void Match( MatchScratch& s, const ImageRegionList& true_regions,
+    const ImageRegionList& computed_regions,
+    std::vector< std::vector<IndexScore> >& image_matches, bool localize );
+
+  const std::vector<ImageRegionList>&                     true_roi_list;
+  const std::vector<ImageRegionList>&                     computed_roi_list;
+  const std::vector<ImageRegionList>&                     compare_roi_list;
+  double                                                  overlap_threshold;
+  const std::map<std::string, int>&                       label_index;
+  std::vector< std::vector< std::vector<IndexScore> > >&  top_matches;
+  std::vector< std::vector< std::vector<IndexScore> > >&  compare_matches;
+  MatchScratch*                                           scratch;
+  ProgressBar&                                            progress;
+};
+
 /******************************************************************************\
 |                          FUNCTION PROTOTYPES                                 |
 \******************************************************************************/
 
+/**PrepareGeometry*************************************************************\
+|   Description: Convert the regions of one image into the form used by        |
+|                ComputeScore()                                                |
+|    Input:                                                                    |
+|      region_list: regions of one image                                       |
+|    Output:                                                                   |
+|      geometry: bounding box and outline of every region                      |
+\******************************************************************************/
+void PrepareGeometry(
+  const ImageRegionList&        region_list,
+  std::vector<RegionGeometry>&  geometry
+);
+
 /**ComputeScore****************************************************************\
-|   Description: Compute score between true_roi and computed_roi               |
+|   Description: Compute score between true_roi and computed_roi.  The         |
+|                bounding boxes are compared first so pairs that do not        |
+|                overlap never reach the polygon clipper.                      |
 |    Input:                                                                    |
-|      true_roi/computed_roi: two rectangles to compare                        |
+|      true_roi/computed_roi: two regions to compare                           |
+|      true_polygon: outline of true_roi prepared for polygon scoring          |
+|      context: polygon scoring scratch space of the calling thread            |
 |    Output: Return the "closeness" score.                                     |
 \******************************************************************************/
 double ComputeScore(
-  const cv::Rect& true_roi,
-  const cv::Rect& computed_roi
+  const RegionGeometry& true_roi,
+  at::PreparedPolygon&  true_polygon,
+  const RegionGeometry& computed_roi,
+  at::ScoreContext&     context
 );
 
 /**DetermineMatches************************************************************\
@@ -65,18 +161,61 @@ double ComputeScore(
 |                computed_roi. Then place them all of the top matches in       |
 |                ascending order in top_matches[image_index][roi_index].       |
 |                Note: If no regions return non-zero score, list may be empty. |
+|                Every pair scoring above overlap_threshold is added to the    |
+|                localization histograms of the label of its true region.      |
 |   Input:                                                                     |
 |     true_roi_list: Ground truth data                                         |
 |     computed_roi_list: Computed Regions to compare to                        |
+|     compare_roi_list: Second run to match against the same prepared ground   |
+|                       truth (empty for none)                                 |
 |     score_threshold: Minumum allowed score                                   |
+|     overlap_threshold: Minimum overlap of a matched pair                     |
+|     num_threads: number of threads to spread the images over                 |
 |   Output:                                                                    |
 |     top_match: lists of top matches for each ROI in true_roi_list            |
+|     compare_matches: top_match of compare_roi_list                           |
+|     labels: every label of the ground truth, sorted                          |
+|     localization: histograms of the matched pairs of each label              |
 \******************************************************************************/
 void DetermineMatches(
   const std::vector<ImageRegionList>&                     true_roi_list,
   const std::vector<ImageRegionList>&                     computed_roi_list,
+  const std::vector<ImageRegionList>&                     compare_roi_list,
   double                                                  score_threshold,
-  std::vector< std::vector< std::vector<IndexScore> > >&  top_matches
+  double                                                  overlap_threshold,
+  int                                                     num_threads,
+  std::vector< std::vector< std::vector<IndexScore> > >&  top_matches,
+  std::vector< std::vector< std::vector<IndexScore> > >&  compare_matches,
+  std::vector<std::string>&                               labels,
+  std::vector<LocalizationHistogram>&                     localization
+);
+
+/**DumpMatches*****************************************************************\
+|   Description: Write every scored pair in top_matches to match_dump_path     |
+|                (see match_dump.h), one column at a time                      |
+|   Input:                                                                     |
+|     computed_roi_list: Computed Regions of interest                          |
+|     top_match: output from DetermineMatches()                                |
+|     program_settings: settings                                               |
+|   Output: Writes the dump, returns false if it could not be written          |
+\******************************************************************************/
+bool DumpMatches(
+  const std::vector<ImageRegionList>&                        computed_roi_list,
+  const std::vector<std::vector<std::vector<IndexScore> > >& top_matches,
+  const Settings&                                            program_settings
+);
+
+/**SaveLocalization************************************************************\
+|   Description: Write the localization histograms and quantiles of every      |
+|                label to localization_path (see WriteLocalization())          |
+|   Input:                                                                     |
+|     labels/localization: output from DetermineMatches()                      |
+|     program_settings: settings                                               |
+\******************************************************************************/
+void SaveLocalization(
+  const std::vector<std::string>&           labels,
+  const std::vector<LocalizationHistogram>& localization,
+  const Settings&                           program_settings
 );
 
 /**PrintResults****************************************************************\
@@ -87,20 +226,102 @@ void DetermineMatches(
 |     top_match: output from DetermineMatches()                                |
 |     program_settings: settings                   TODO                        |
 |   Output: Write results to output stream determined by program_settings      |
+|     computed_roi_matches: true regions matched by each computed region       |
+|     image_counts: true/false positives and false negatives of each image     |
 \******************************************************************************/
 void PrintResults(
   const std::vector<ImageRegionList>&                        true_roi_list,
   const std::vector<ImageRegionList>&                        computed_roi_list,
   const std::vector<std::vector<std::vector<IndexScore> > >& top_matches,
   const Settings&                                            program_settings,
-  std::vector< std::vector< std::vector<IndexScore> > >&    computed_roi_matches
+  std::vector< std::vector< std::vector<IndexScore> > >&    computed_roi_matches,
+  std::vector<ImageCounts>&                                  image_counts
+);
+
+/**SaveCurves******************************************************************\
+|   Description: Place every computed region and every detected ground truth   |
+|                on the score axis and write the exact precision-recall curve  |
+|                to pr_curve_path.  A ground truth is detected at the best     |
+|                score of the computed regions matching it.  The FROC          |
+|                sensitivities are printed from the same curve.  The same      |
+|                sweep fills a curve for every size bucket, a computed region  |
+|                counts in a bucket if it matches a ground truth of the bucket |
+|                or if it matches nothing and is itself in the bucket.         |
+|   Input:                                                                     |
+|     true_roi_list: Ground truth data                                         |
+|     computed_roi_list: Computed Regions of interest                          |
+|     computed_roi_matches: output from PrintResults()                         |
+|     program_settings: settings                                               |
+\******************************************************************************/
+void SaveCurves(
+  const std::vector<ImageRegionList>& true_roi_list,
+  const std::vector<ImageRegionList>& computed_roi_list,
+  const std::vector< std::vector< std::vector<IndexScore> > >&
+                                      computed_roi_matches,
+  const Settings&                     program_settings
+);
+
+/**PrintConfidence*************************************************************\
+|   Description: Print bootstrap confidence intervals of the detection rate,   |
+|                precision and false positives per image when                  |
+|                bootstrap_samples is set                                      |
+|   Input:                                                                     |
+|     image_counts: output from PrintResults()                                 |
+|     program_settings: settings                                               |
+\******************************************************************************/
+void PrintConfidence(
+  const std::vector<ImageCounts>& image_counts,
+  const Settings&                 program_settings
+);
+
+/**CompareRuns*****************************************************************\
+|   Description: Paired comparison of the compared run (B) against the        |
+|                computed regions (A) on the same images.  Prints the change   |
+|                in true and false positives with permutation test p-values    |
+|                and the compare_top images with the largest regression (lost  |
+|                true positives plus new false positives), and writes the      |
+|                counts of every image to compare_results_path.                |
+|   Input:                                                                     |
+|     true_roi_list: Ground truth data                                         |
+|     image_counts: output from PrintResults() for run A                       |
+|     compare_counts: output from PrintResults() for run B                     |
+|     program_settings: settings                                               |
+\******************************************************************************/
+void CompareRuns(
+  const std::vector<ImageRegionList>& true_roi_list,
+  const std::vector<ImageCounts>&     image_counts,
+  const std::vector<ImageCounts>&     compare_counts,
+  const Settings&                     program_settings
+);
+
+/**SaveResults*****************************************************************\
+|   Description: Write every computed region to output_results_path in the     |
+|                computed ROI format.  Each region is followed by TP or FP,    |
+|                the index of its best matching true region (-1 for none) and  |
+|                their overlap score.  Everything goes through one buffered    |
+|                writer.                                                       |
+|   Input:                                                                     |
+|     computed_roi_list: Computed Regions of interest                          |
+|     computed_roi_matches: output from PrintResults()                         |
+|     program_settings: settings                                               |
+|   Output: Writes the results file, returns false if it could not be written  |
+\******************************************************************************/
+bool SaveResults(
+  const std::vector<ImageRegionList>& computed_roi_list,
+  const std::vector< std::vector< std::vector<IndexScore> > >&
+                                computed_roi_matches,
+  const Settings&               program_settings
 );
 
 /**DrawResults*****************************************************************\
-|   Description: Draws both true and computed regions to image                 |
+|   Description: Draws both true and computed regions to image, or with        |
+|                draw_format svg/json writes them as a vector overlay of each  |
+|                image without reading the image at all                        |
 |   Input:                                                                     |
 |     true/computed_roi_list: true and computed regions of interest            |
 |     program_settings: settings               TODO                            |
+|     gallery_images: output from GalleryImages()                              |
+|     image_cache: decoded images                                              |
 |   Output: Writes all the images to a folder.                                 |
 \******************************************************************************/
 void DrawResults(
@@ -108,7 +329,56 @@ void DrawResults(
   const std::vector<ImageRegionList>& computed_roi_list,
   const std::vector< std::vector< std::vector<IndexScore> > >&
                                 computed_roi_matches,
-  const Settings&               program_settings
+  const Settings&               program_settings,
+  const std::vector<bool>&      gallery_images,
+  ImageCache&                   image_cache
+);
+
+/**GalleryImages***************************************************************\
+|   Description: Images SaveGallery() will read, the ones with a false         |
+|                positive or a missed ground truth.  DrawResults() keeps only  |
+|                these in the memory cache.                                    |
+|   Input:                                                                     |
+|     computed_roi_list: computed regions of interest                          |
+|     top_matches: output from DetermineMatches()                              |
+|     computed_roi_matches: output from PrintResults()                         |
+|     program_settings: settings                                               |
+|   Output:                                                                    |
+|     images: true for every image read, empty without a gallery               |
+\******************************************************************************/
+void GalleryImages(
+  const std::vector<ImageRegionList>& computed_roi_list,
+  const std::vector< std::vector< std::vector<IndexScore> > >& top_matches,
+  const std::vector< std::vector< std::vector<IndexScore> > >&
+                                computed_roi_matches,
+  const Settings&               program_settings,
+  std::vector<bool>&            images
+);
+
+/**SaveGallery*****************************************************************\
+|   Description: Crop a padded chip around every false positive and missed     |
+|                ground truth and pack them into mosaic sheets in              |
+|                gallery_folder, with index.csv listing the cell of each chip. |
+|                False positives are ordered by detection score and misses by  |
+|                their best overlap, highest first.  Only images with errors   |
+|                are decoded, spread over threads, at the same scale as        |
+|                DrawResults() and latest drawn first so images it kept in the |
+|                memory cache are read before they are evicted.                |
+|   Input:                                                                     |
+|     true/computed_roi_list: true and computed regions of interest            |
+|     top_matches: output from DetermineMatches()                              |
+|     computed_roi_matches: output from PrintResults()                         |
+|     program_settings: settings                                               |
+|     image_cache: decoded images                                              |
+\******************************************************************************/
+void SaveGallery(
+  const std::vector<ImageRegionList>& true_roi_list,
+  const std::vector<ImageRegionList>& computed_roi_list,
+  const std::vector< std::vector< std::vector<IndexScore> > >& top_matches,
+  const std::vector< std::vector< std::vector<IndexScore> > >&
+                                computed_roi_matches,
+  const Settings&               program_settings,
+  ImageCache&                   image_cache
 );
 
 /**DescendingSort**************************************************************\
@@ -136,6 +406,17 @@ int main(int argc, char *argv[])
   // of the <roi_index> region of interest in <image>
   std::vector< std::vector< std::vector<IndexScore> > > top_matches;
   std::vector< std::vector< std::vector<IndexScore> > > computed_roi_matches;
+  std::vector<ImageCounts> image_counts;
+
+  // the same for the compared run (only used with compare_roi_path)
+  std::vector<ImageRegionList> compare_roi_list;
+  std::vector< std::vector< std::vector<IndexScore> > > compare_matches;
+  std::vector< std::vector< std::vector<IndexScore> > > compare_roi_matches;
+  std::vector<ImageCounts> compare_counts;
+
+  // localization histograms of the matched pairs of each ground truth label
+  std::vector<std::string> labels;
+  std::vector<LocalizationHistogram> localization;
 
   /****************************************************************************\
   |                          INTIALIZE VARIABLES                               |
@@ -143,25 +424,66 @@ int main(int argc, char *argv[])
   LoadSettings(argc, argv, program_settings);
 
   // loads the files into vectors of ImageRegionList objects
-  LoadTrueROI(program_settings.true_roi_path, true_roi_list);
+  LoadTrueROI(program_settings.true_roi_path, program_settings.size_buckets,
+              true_roi_list);
   LoadComputedROI(program_settings.computed_roi_path,
-                  program_settings.score_threshold, computed_roi_list);
+                  program_settings.score_threshold,
+                  program_settings.size_buckets, computed_roi_list);
+  if ( !program_settings.compare_roi_path.empty() )
+    LoadComputedROI(program_settings.compare_roi_path,
+                    program_settings.score_threshold,
+                    program_settings.size_buckets, compare_roi_list);
   
   /****************************************************************************\
   |                              RUN PROGRAM                                   |
   \****************************************************************************/
 
   // build list of top matching computed regions for each roi in ground truth
-  DetermineMatches(true_roi_list, computed_roi_list,
-                   program_settings.score_threshold, top_matches);
+  DetermineMatches(true_roi_list, computed_roi_list, compare_roi_list,
+                   program_settings.score_threshold,
+                   program_settings.overlap_threshold,
+                   ThreadCount(program_settings.num_threads), top_matches,
+                   compare_matches, labels, localization);
+
+  // save every scored pair for later analysis
+  DumpMatches(computed_roi_list, top_matches, program_settings);
+  SaveLocalization(labels, localization, program_settings);
 
   // print results
   PrintResults(true_roi_list, computed_roi_list, top_matches, program_settings,
-               computed_roi_matches);
-
-  // draw results on images and save
+               computed_roi_matches, image_counts);
+  PrintConfidence(image_counts, program_settings);
+  if ( !compare_roi_list.empty() )
+  {
+    std::cout << "Compared run " << program_settings.compare_roi_path
+              << std::endl;
+    PrintResults(true_roi_list, compare_roi_list, compare_matches,
+                 program_settings, compare_roi_matches, compare_counts);
+    CompareRuns(true_roi_list, image_counts, compare_counts,
+                program_settings);
+  }
+  SaveCurves(true_roi_list, computed_roi_list, computed_roi_matches,
+             program_settings);
+
+  // write the results of every region
+  SaveResults(computed_roi_list, computed_roi_matches, program_settings);
+
+  // draw results on images and save, both read the images through the
+  // same cache
+  ImageCache image_cache(
+    static_cast<size_t>(std::max(program_settings.image_cache_memory_mb, 0))
+      << 20,
+    program_settings.image_cache_folder,
+    static_cast<boost::uint64_t>(
+      std::max(program_settings.image_cache_disk_mb, 0)) << 20);
+  std::vector<bool> gallery_images;
+  GalleryImages(computed_roi_list, top_matches, computed_roi_matches,
+                program_settings, gallery_images);
   DrawResults(true_roi_list, computed_roi_list, computed_roi_matches, 
-              program_settings);
+              program_settings, gallery_images, image_cache);
+  SaveGallery(true_roi_list, computed_roi_list, top_matches,
+              computed_roi_matches, program_settings, image_cache);
+  image_cache.Trim();
   
   // print settings XXX Remove Me
 //  PrintSettings(program_settings, std::cout);
@@ -174,8 +496,12 @@ int main(int argc, char *argv[])
 \******************************************************************************/
 void DetermineMatches(const std::vector<ImageRegionList>& true_roi_list,
   const std::vector<ImageRegionList>& computed_roi_list,
-  double score_threshold, 
-  std::vector< std::vector< std::vector<IndexScore> > >& top_matches )
+  const std::vector<ImageRegionList>& compare_roi_list,
+  double score_threshold, double overlap_threshold, int num_threads,
+  std::vector< std::vector< std::vector<IndexScore> > >& top_matches,
+  std::vector< std::vector< std::vector<IndexScore> > >& compare_matches,
+  std::vector<std::string>& labels,
+  std::vector<LocalizationHistogram>& localization )
 {
   // iterator typedefs
   typedef std::vector<ImageRegionList>::const_iterator
@@ -184,15 +510,6 @@ void DetermineMatches(const std::vector<ImageRegionList>& true_roi_list,
   typedef std::vector< std::vector< std::vector<IndexScore> > >::iterator
           Vector3DIterator;
 
-  typedef std::vector< std::vector<IndexScore> >::iterator
-          Vector2DIterator;
-
-  typedef std::vector<cv::Rect>::const_iterator
-          ConstRectIterator;
-      
-  typedef std::vector<float>::const_iterator
-          ConstScoreIterator;
-
   // test for valid inputs
   {
     assert(top_matches.empty());
@@ -204,6 +521,12 @@ void DetermineMatches(const std::vector<ImageRegionList>& true_roi_list,
     for ( ; computed_roi_it != computed_roi_list.end();
             ++true_roi_it, ++computed_roi_it )
       assert( true_roi_it->image_path == computed_roi_it->image_path );
+
+    // the compared run must list the same images
+    assert(compare_roi_list.empty() ||
+           compare_roi_list.size()==true_roi_list.size());
+    for ( size_t i = 0; i < compare_roi_list.size(); ++i )
+      assert( true_roi_list[i].image_path == compare_roi_list[i].image_path );
   }
    
   // initialize 1st dimension of top_matches
@@ -218,67 +541,135 @@ void DetermineMatches(const std::vector<ImageRegionList>& true_roi_list,
             ++top_matches_it, ++true_roi_it)
       top_matches_it->resize(true_roi_it->regions.size());
   }
-
-  // calculate unsorted top matches and store (3d dimension of top_matches)
+  compare_matches.clear();
+  if ( !compare_roi_list.empty() )
+    compare_matches = top_matches;
+
+  // number the ground truth labels so each thread can keep its histograms
+  // in a plain array
+  std::map<std::string, int> label_index;
+  for ( ConstRegionIterator it = true_roi_list.begin();
+        it != true_roi_list.end(); ++it )
+    for ( size_t i = 0; i < it->labels.size(); ++i )
+      label_index[it->labels[i]] = 0;
+  labels.clear();
+  for ( std::map<std::string, int>::iterator it = label_index.begin();
+        it != label_index.end(); ++it )
   {
-    // iterate through all three
-    Vector3DIterator top_matches_it = top_matches.begin();
-    ConstRegionIterator true_roi_it = true_roi_list.begin();
-    ConstRegionIterator computed_roi_it = computed_roi_list.begin();
-    for ( ; true_roi_it != true_roi_list.end();
-            ++top_matches_it, ++true_roi_it, ++computed_roi_it )
-    {
-      // for each region in current index of true_roi_list
-      ConstRectIterator true_regions_it = true_roi_it->regions.begin();
-      ConstRectIterator true_regions_end = true_roi_it->regions.end();
-      Vector2DIterator top_regions_it = top_matches_it->begin();
-//      Vector2DIterator top_regions_end = top_matches_it->end();
-      for ( ; true_regions_it != true_regions_end;
-              ++true_regions_it, ++top_regions_it )
-      {
-        // compare against every region in current index of computed_roi
-        ConstRectIterator computed_regions_it =
-          computed_roi_it->regions.begin();
-        ConstRectIterator computed_regions_end =
-          computed_roi_it->regions.end();
-        ConstScoreIterator computed_scores_it =
-          computed_roi_it->scores.begin();
-        int index = 0;
-        for ( ; computed_regions_it != computed_regions_end;
-                ++computed_regions_it, ++computed_scores_it, ++index )
-        {
-          static double score;
-          score = ComputeScore(*true_regions_it, *computed_regions_it);
+    it->second = labels.size();
+    labels.push_back(it->first);
+  }
 
-          // only save if score is above zero (which is always should be)
-          if ( score > 0 )
-            top_regions_it->push_back(IndexScore(index, score));
-        }
-      }
-    }
+  // calculate and sort the top matches of every image (3d dimension of
+  // top_matches), images are independent so they are spread over threads
+  ProgressBar progress_bar(cout, "Matching ", true_roi_list.size(), 60);
+  boost::scoped_array<MatchScratch> scratch(new MatchScratch[num_threads]);
+  for ( int i = 0; i < num_threads; ++i )
+    scratch[i].localization.resize(labels.size());
+  MatchImage match_image(true_roi_list, computed_roi_list, compare_roi_list,
+                         overlap_threshold, label_index, top_matches,
+                         compare_matches, scratch.get(), progress_bar);
+  ParallelFor(true_roi_list.size(), num_threads, match_image);
+  progress_bar.finish();
+
+  // merge the histograms of every thread
+  localization.assign(labels.size(), LocalizationHistogram());
+  for ( int i = 0; i < num_threads; ++i )
+    for ( size_t j = 0; j < labels.size(); ++j )
+      localization[j] += scratch[i].localization[j];
+}
+
+void MatchImage::operator()( size_t image_index, int thread )
+{
+  MatchScratch& s = scratch[thread];
+  const ImageRegionList& true_regions = true_roi_list[image_index];
+
+  PrepareGeometry(true_regions, s.true_geometry);
+
+  // index the ground truth by bounding box and prepare its outlines, each
+  // truth is compared against many computed regions
+  s.true_boxes.resize(s.true_geometry.size());
+  while ( s.true_polygons.size() < s.true_geometry.size() )
+    s.true_polygons.push_back(
+      boost::shared_ptr<at::PreparedPolygon>(new at::PreparedPolygon));
+  for ( size_t i = 0; i < s.true_geometry.size(); ++i )
+  {
+    s.true_boxes[i] = s.true_geometry[i].box;
+    s.true_polygons[i]->prepare(s.true_geometry[i].outline);
   }
+  s.true_index.build(s.true_boxes);
+
+  s.true_labels.resize(true_regions.labels.size());
+  for ( size_t i = 0; i < s.true_labels.size(); ++i )
+    s.true_labels[i] = label_index.find(true_regions.labels[i])->second;
+
+  Match(s, true_regions, computed_roi_list[image_index],
+        top_matches[image_index], true);
+  if ( !compare_roi_list.empty() )
+    Match(s, true_regions, compare_roi_list[image_index],
+          compare_matches[image_index], false);
+  progress.add();
+}
 
-  // sort lists of top matches
+void MatchImage::Match( MatchScratch& s, const ImageRegionList& true_regions,
+  const ImageRegionList& computed_regions,
+  std::vector< std::vector<IndexScore> >& image_matches, bool localize )
+{
+  PrepareGeometry(computed_regions, s.computed_geometry);
+
+  // compare every computed region against the ground truth it overlaps,
+  // computed regions are visited in order so each list stays in the
+  // order of the computed regions before sorting
+  for ( size_t computed_index = 0;
+        computed_index < s.computed_geometry.size(); ++computed_index )
   {
-    // iterate through all three
-    Vector3DIterator top_matches_it = top_matches.begin();
-    for ( ; top_matches_it != top_matches.end(); ++top_matches_it )
+    s.candidates.clear();
+    s.true_index.query(s.computed_geometry[computed_index].box, s.candidates);
+
+    for ( size_t i = 0; i < s.candidates.size(); ++i )
     {
-      // for each region in current index of true_roi_list
-      Vector2DIterator top_regions_it = top_matches_it->begin();
-      Vector2DIterator top_regions_end = top_matches_it->end();
-      for ( ; top_regions_it != top_regions_end; ++top_regions_it )
-        sort(top_regions_it->begin(),top_regions_it->end(),DescendingSortFunc);
+      double score = ComputeScore(s.true_geometry[s.candidates[i]],
+                                  *s.true_polygons[s.candidates[i]],
+                                  s.computed_geometry[computed_index],
+                                  s.context);
+
+      // only save if score is above zero
+      if ( score > 0 )
+        image_matches[s.candidates[i]].push_back(
+          IndexScore(computed_index, score));
+
+      // center offset and scale of a matched pair, relative to the truth.
+      // Boxes without width or height would give inf or NaN, they are only
+      // counted.
+      if ( localize && score > overlap_threshold )
+      {
+        const cv::Rect& t = true_regions.regions[s.candidates[i]];
+        const cv::Rect& c = computed_regions.regions[computed_index];
+        LocalizationHistogram& histogram =
+          s.localization[s.true_labels[s.candidates[i]]];
+        if ( t.width <= 0 || t.height <= 0 || c.width <= 0 || c.height <= 0 )
+          ++histogram.degenerate;
+        else
+          histogram.Add(score,
+            ( c.x + 0.5 * c.width - t.x - 0.5 * t.width ) / t.width,
+            ( c.y + 0.5 * c.height - t.y - 0.5 * t.height ) / t.height,
+            std::log(static_cast<double>(c.width) / t.width),
+            std::log(static_cast<double>(c.height) / t.height));
+      }
     }
   }
 
+  // sort lists of top matches
+  for ( size_t i = 0; i < image_matches.size(); ++i )
+    sort(image_matches[i].begin(), image_matches[i].end(), DescendingSortFunc);
 }
 
 void PrintResults( const std::vector<ImageRegionList>& true_roi_list,
   const std::vector<ImageRegionList>& computed_roi_list,
   const std::vector< std::vector< std::vector<IndexScore> > >& top_matches,
   const Settings& program_settings,
-  std::vector< std::vector< std::vector<IndexScore> > >& computed_roi_matches )
+  std::vector< std::vector< std::vector<IndexScore> > >& computed_roi_matches,
+  std::vector<ImageCounts>& image_counts )
 {
   // TODO: add return value, struct for holding results
 
@@ -317,6 +708,7 @@ void PrintResults( const std::vector<ImageRegionList>& true_roi_list,
   // computed region of interest associates, in the case of SEMI_EXCLUSIVE_2
   // and EXCLUSIVE, these lists will be restricted to have only one element each
   computed_roi_matches.resize( top_matches.size() );
+  image_counts.assign( top_matches.size(), ImageCounts() );
 
   // keep running total number of each of these
   int false_positives = 0;
@@ -328,6 +720,11 @@ void PrintResults( const std::vector<ImageRegionList>& true_roi_list,
   for ( size_t image_index = 0; image_index < top_matches.size();
         ++image_index )
   {
+    // totals before this image, the differences are the image's own counts
+    int previous_false_positives = false_positives;
+    int previous_true_positives = true_positives;
+    int previous_total_truth = total_truth;
+
     /**************************************************************************\
     |                        COUNT FALSE POSITIVES                             |
     \**************************************************************************/
@@ -401,6 +798,12 @@ void PrintResults( const std::vector<ImageRegionList>& true_roi_list,
         if ( top_matches[image_index][top_roi_index][0].score 
            > program_settings.overlap_threshold )
           ++true_positives;
+
+    ImageCounts& counts = image_counts[image_index];
+    counts.false_positives = false_positives - previous_false_positives;
+    counts.true_positives = true_positives - previous_true_positives;
+    counts.false_negatives =
+      ( total_truth - previous_total_truth ) - counts.true_positives;
   }
 
   // output results TODO: add some output options
@@ -411,25 +814,999 @@ void PrintResults( const std::vector<ImageRegionList>& true_roi_list,
 //              << "%" << std::endl
 }
 
-double ComputeScore(const cv::Rect& true_roi, const cv::Rect& computed_roi)
+void PrepareGeometry(const ImageRegionList& region_list,
+  std::vector<RegionGeometry>& geometry)
+{
+  geometry.resize(region_list.regions.size());
+
+  for ( size_t i = 0; i < geometry.size(); ++i )
+  {
+    const cv::Rect& roi = region_list.regions[i];
+    const RegionShape& shape = region_list.shapes[i];
+    RegionGeometry& region = geometry[i];
+
+    region.box = at::Rect(roi.x, roi.y, roi.width, roi.height);
+    region.is_rect = ( shape.type == RegionShape::RECT );
+    region.is_ellipse = ( shape.type == RegionShape::ELLIPSE );
+    region.is_mask = ( shape.type == RegionShape::MASK );
+    region.outline.clear();
+
+    if ( region.is_mask )
+      region.mask = at::RLE(shape.mask_size.height, shape.mask_size.width,
+                            shape.counts.empty() ? 0 : &shape.counts[0],
+                            shape.counts.size());
+    else if ( region.is_ellipse )
+    {
+      const cv::RotatedRect& e = shape.ellipse;
+      region.ellipse = at::Ellipse(e.center.x, e.center.y,
+        0.5f * e.size.width, 0.5f * e.size.height, e.angle);
+    }
+    else if ( region.is_rect )
+    {
+      region.outline.push_back(at::Point(roi.x, roi.y));
+      region.outline.push_back(at::Point(roi.x + roi.width, roi.y));
+      region.outline.push_back(at::Point(roi.x + roi.width,
+                                         roi.y + roi.height));
+      region.outline.push_back(at::Point(roi.x, roi.y + roi.height));
+    }
+    else
+    {
+      for ( size_t j = 0; j < shape.points.size(); ++j )
+        region.outline.push_back(at::Point(shape.points[j].x,
+                                           shape.points[j].y));
+    }
+  }
+}
+
+double ComputeScore(const RegionGeometry& true_roi,
+  at::PreparedPolygon& true_polygon, const RegionGeometry& computed_roi,
+  at::ScoreContext& context)
 {
-  at::Rect true_roi_at(true_roi.x,
-                       true_roi.y,
-                       true_roi.width,
-                       true_roi.height);
+  // regions whose bounding boxes do not overlap can't overlap either
+  at::Rect overlap;
+  at::intersectRect(overlap, true_roi.box, computed_roi.box);
+  if ( overlap.width <= 0 || overlap.height <= 0 )
+    return 0.0;
+
+  if ( true_roi.is_rect && computed_roi.is_rect )
+    return at::computeScore(true_roi.box, computed_roi.box);
+
+  // the score is symmetric so masks and then ellipses always go first
+  if ( true_roi.is_mask && computed_roi.is_mask )
+    return at::computeScore(true_roi.mask, computed_roi.mask);
+  if ( true_roi.is_mask || computed_roi.is_mask )
+  {
+    const RegionGeometry& mask = true_roi.is_mask ? true_roi : computed_roi;
+    const RegionGeometry& other = true_roi.is_mask ? computed_roi : true_roi;
+    if ( other.is_ellipse )
+      return at::computeScore(mask.mask, other.ellipse, context);
+    return at::computeScore(mask.mask, other.outline, context);
+  }
 
-  at::Rect computed_roi_at(computed_roi.x,
-                           computed_roi.y,
-                           computed_roi.width,
-                           computed_roi.height);
+  if ( true_roi.is_ellipse && computed_roi.is_ellipse )
+    return at::computeScore(true_roi.ellipse, computed_roi.ellipse);
+  if ( true_roi.is_ellipse )
+    return at::computeScore(true_roi.ellipse, computed_roi.outline, context);
+  if ( computed_roi.is_ellipse )
+    return at::computeScore(computed_roi.ellipse, true_roi.outline, context);
 
-  return at::computeScore(true_roi_at, computed_roi_at);
+  return at::computeScore(true_polygon, computed_roi.outline, context);
 }
 
+void SaveCurves(const std::vector<ImageRegionList>& true_roi_list,
+  const std::vector<ImageRegionList>& computed_roi_list,
+  const std::vector< std::vector< std::vector<IndexScore> > >&
+  computed_roi_matches, const Settings& program_settings)
+{
+  const fs::path& path = program_settings.pr_curve_path;
+
+  const size_t bucket_count = program_settings.size_buckets.size();
+
+  std::vector<ScoredEvent> events;
+  std::vector< std::vector<ScoredEvent> > bucket_events(bucket_count);
+  std::vector<int> bucket_truth(bucket_count, 0);
+  std::vector<size_t> bucket_marker(bucket_count);
+  std::vector<double> truth_scores;
+  int total_truth = 0;
+  for ( size_t image_index = 0; image_index < computed_roi_list.size();
+        ++image_index )
+  {
+    const std::vector<float>& scores = computed_roi_list[image_index].scores;
+    const std::vector<int>& computed_buckets =
+      computed_roi_list[image_index].size_buckets;
+    const std::vector<int>& true_buckets =
+      true_roi_list[image_index].size_buckets;
+    const std::vector< std::vector<IndexScore> >& matches =
+      computed_roi_matches[image_index];
+
+    // best score of the computed regions matching each ground truth
+    truth_scores.assign(true_roi_list[image_index].regions.size(), 0.0);
+    std::vector<bool> found(truth_scores.size(), false);
+    total_truth += truth_scores.size();
+
+    // bucket_marker[b] == i + 1 once computed region i is counted in bucket b
+    bucket_marker.assign(bucket_count, 0);
+
+    for ( size_t i = 0; i < matches.size(); ++i )
+    {
+      events.push_back(ScoredEvent(scores[i], matches[i].empty() ?
+        ScoredEvent::FALSE_DETECTION : ScoredEvent::MATCHED_DETECTION));
+      if ( matches[i].empty() && computed_buckets[i] >= 0 )
+        bucket_events[computed_buckets[i]].push_back(
+          ScoredEvent(scores[i], ScoredEvent::FALSE_DETECTION));
+
+      for ( size_t j = 0; j < matches[i].size(); ++j )
+      {
+        size_t truth = matches[i][j].index;
+        if ( !found[truth] || scores[i] > truth_scores[truth] )
+          truth_scores[truth] = scores[i];
+        found[truth] = true;
+
+        int bucket = true_buckets[truth];
+        if ( bucket >= 0 && bucket_marker[bucket] != i + 1 )
+        {
+          bucket_marker[bucket] = i + 1;
+          bucket_events[bucket].push_back(
+            ScoredEvent(scores[i], ScoredEvent::MATCHED_DETECTION));
+        }
+      }
+    }
+
+    for ( size_t i = 0; i < truth_scores.size(); ++i )
+    {
+      if ( true_buckets[i] >= 0 )
+        ++bucket_truth[true_buckets[i]];
+      if ( !found[i] )
+        continue;
+      events.push_back(ScoredEvent(truth_scores[i],
+                                   ScoredEvent::DETECTED_TRUTH));
+      if ( true_buckets[i] >= 0 )
+        bucket_events[true_buckets[i]].push_back(
+          ScoredEvent(truth_scores[i], ScoredEvent::DETECTED_TRUTH));
+    }
+  }
+
+  std::vector<CurvePoint> curve;
+  DetectionCurve(events, curve);
+
+  // counts and average precision of every size bucket
+  if ( bucket_count > 0 )
+  {
+    std::cout << "Size buckets (bounding box area)" << std::endl
+              << "  " << std::setw(20) << std::left << "area" << std::right
+              << std::setw(8) << "truth" << std::setw(8) << "TP"
+              << std::setw(8) << "FP" << std::setw(8) << "FN"
+              << "  " << std::setw(8) << "AP" << std::endl;
+    // the row after the last bucket is every region
+    std::vector<CurvePoint> bucket_curve;
+    for ( size_t b = 0; b <= bucket_count; ++b )
+    {
+      std::ostringstream range;
+      int truth = total_truth;
+      if ( b < bucket_count )
+      {
+        DetectionCurve(bucket_events[b], bucket_curve);
+        truth = bucket_truth[b];
+        range << '[' << program_settings.size_buckets[b] << ", ";
+        if ( b + 1 < bucket_count )
+          range << program_settings.size_buckets[b + 1] << ')';
+        else
+          range << "inf)";
+      }
+      else
+      {
+        bucket_curve = curve;
+        range << "all";
+      }
+
+      CurvePoint last;
+      if ( !bucket_curve.empty() )
+        last = bucket_curve.back();
+      std::ios::fmtflags flags = std::cout.flags();
+      std::streamsize precision = std::cout.precision();
+      std::cout << "  " << std::setw(20) << std::left << range.str()
+                << std::right << std::setw(8) << truth
+                << std::setw(8) << last.truths_found
+                << std::setw(8) << last.false_detections
+                << std::setw(8) << truth - last.truths_found
+                << "  " << std::setw(8) << std::fixed << std::setprecision(4)
+                << AveragePrecision(bucket_curve, truth) << std::endl;
+      std::cout.flags(flags);
+      std::cout.precision(precision);
+    }
+  }
+
+  // sensitivity at the standard false positive per image rates
+  std::vector<double> sensitivity;
+  FrocSensitivity(curve, total_truth, computed_roi_list.size(),
+                  FROC_FP_RATES, FROC_POINTS, sensitivity);
+  double average = 0.0;
+  std::cout << "FROC (FP/image: sensitivity)" << std::endl;
+  for ( int i = 0; i < FROC_POINTS; ++i )
+  {
+    std::cout << "  " << std::setw(5) << FROC_FP_RATES[i] << ": "
+              << sensitivity[i] << std::endl;
+    average += sensitivity[i] / FROC_POINTS;
+  }
+  std::cout << "  average: " << average << std::endl;
+
+  if ( path.empty() )
+    return;
+  if ( path.has_parent_path() && !fs::exists(path.parent_path()) )
+    fs::create_directories(path.parent_path());
+  if ( !WritePRCurve(path, curve, total_truth) )
+    std::cout << "Could not write " << path << std::endl;
+}
+
+void PrintConfidence(const std::vector<ImageCounts>& image_counts,
+  const Settings& program_settings)
+{
+  if ( program_settings.bootstrap_samples <= 0 )
+    return;
+
+  BootstrapResult result;
+  BootstrapMetrics(image_counts, program_settings.bootstrap_samples,
+                   program_settings.confidence_level,
+                   program_settings.bootstrap_seed,
+                   ThreadCount(program_settings.num_threads), result);
+
+  std::cout << "Bootstrap (" << program_settings.bootstrap_samples
+            << " samples, " << 100.0 * program_settings.confidence_level
+            << "% intervals)" << std::endl
+            << "  Detection Rate : " << result.detection_rate.value << " ["
+            << result.detection_rate.lower << ", "
+            << result.detection_rate.upper << "]" << std::endl
+            << "  Precision      : " << result.precision.value << " ["
+            << result.precision.lower << ", "
+            << result.precision.upper << "]" << std::endl
+            << "  FP / Image     : " << result.fp_per_image.value << " ["
+            << result.fp_per_image.lower << ", "
+            << result.fp_per_image.upper << "]" << std::endl;
+}
+
+void CompareRuns(const std::vector<ImageRegionList>& true_roi_list,
+  const std::vector<ImageCounts>& image_counts,
+  const std::vector<ImageCounts>& compare_counts,
+  const Settings& program_settings)
+{
+  const size_t images = image_counts.size();
+
+  // per-image differences, B - A
+  std::vector<boost::int32_t> tp_delta(images), fp_delta(images);
+  std::vector<IndexScore> regressions(images);
+  int tp_total = 0, fp_total = 0;
+  for ( size_t i = 0; i < images; ++i )
+  {
+    tp_delta[i] = compare_counts[i].true_positives -
+                  image_counts[i].true_positives;
+    fp_delta[i] = compare_counts[i].false_positives -
+                  image_counts[i].false_positives;
+    tp_total += tp_delta[i];
+    fp_total += fp_delta[i];
+    regressions[i] = IndexScore(i, fp_delta[i] - tp_delta[i]);
+  }
+
+  int threads = ThreadCount(program_settings.num_threads);
+  std::cout << "Compared - computed" << std::endl
+            << "  True Positives : " << std::showpos << tp_total
+            << std::noshowpos << " (p = "
+            << PairedPermutationTest(tp_delta,
+                 program_settings.permutation_samples,
+                 program_settings.bootstrap_seed, threads) << ")" << std::endl
+            << "  False Positives: " << std::showpos << fp_total
+            << std::noshowpos << " (p = "
+            << PairedPermutationTest(fp_delta,
+                 program_settings.permutation_samples,
+                 program_settings.bootstrap_seed, threads) << ")" << std::endl;
+
+  // only the worst images need to be in order
+  size_t top = std::min(images,
+    static_cast<size_t>(std::max(program_settings.compare_top, 0)));
+  std::partial_sort(regressions.begin(), regressions.begin() + top,
+                    regressions.end(), DescendingSortFunc);
+  if ( top > 0 && regressions[0].score > 0 )
+    std::cout << "Largest regressions (TP computed -> compared, "
+              << "FP computed -> compared)" << std::endl;
+  for ( size_t i = 0; i < top && regressions[i].score > 0; ++i )
+  {
+    size_t image = regressions[i].index;
+    std::cout << "  " << true_roi_list[image].image_path.string() << "  TP "
+              << image_counts[image].true_positives << " -> "
+              << compare_counts[image].true_positives << ", FP "
+              << image_counts[image].false_positives << " -> "
+              << compare_counts[image].false_positives << std::endl;
+  }
+
+  const fs::path& path = program_settings.compare_results_path;
+  if ( path.empty() )
+    return;
+  if ( path.has_parent_path() && !fs::exists(path.parent_path()) )
+    fs::create_directories(path.parent_path());
+
+  BufferedWriter out;
+  bool written = out.Open(path);
+  if ( written )
+  {
+    out.Write("image,tp,fp,fn,compare_tp,compare_fp,compare_fn,delta_tp,"
+              "delta_fp\n");
+    for ( size_t i = 0; i < images; ++i )
+      out.Write(true_roi_list[i].image_path.string()).Write(',')
+         .Write(static_cast<long>(image_counts[i].true_positives)).Write(',')
+         .Write(static_cast<long>(image_counts[i].false_positives)).Write(',')
+         .Write(static_cast<long>(image_counts[i].false_negatives)).Write(',')
+         .Write(static_cast<long>(compare_counts[i].true_positives)).Write(',')
+         .Write(static_cast<long>(compare_counts[i].false_positives))
+         .Write(',')
+         .Write(static_cast<long>(compare_counts[i].false_negatives))
+         .Write(',')
+         .Write(static_cast<long>(tp_delta[i])).Write(',')
+         .Write(static_cast<long>(fp_delta[i])).Write('\n');
+    written = out.Close();
+  }
+  if ( !written )
+    std::cout << "Could not write " << path << std::endl;
+}
+
+bool DumpMatches(const std::vector<ImageRegionList>& computed_roi_list,
+  const std::vector< std::vector< std::vector<IndexScore> > >& top_matches,
+  const Settings& program_settings)
+{
+  const fs::path& path = program_settings.match_dump_path;
+  if ( path.empty() )
+    return true;
+
+  if ( path.has_parent_path() && !fs::exists(path.parent_path()) &&
+       !fs::create_directories(path.parent_path()) )
+  {
+    std::cout << "Could not create folder " << path.parent_path()
+              << std::endl;
+    return false;
+  }
+
+  // string tables, labels are numbered in sorted order
+  std::vector<std::string> images(computed_roi_list.size());
+  std::map<std::string, boost::uint32_t> label_ids;
+  boost::uint64_t rows = 0;
+  for ( size_t image_index = 0; image_index < computed_roi_list.size();
+        ++image_index )
+  {
+    const ImageRegionList& regions = computed_roi_list[image_index];
+    images[image_index] = regions.image_path.string();
+    for ( size_t i = 0; i < regions.labels.size(); ++i )
+      label_ids[regions.labels[i]] = 0;
+    for ( size_t i = 0; i < top_matches[image_index].size(); ++i )
+      rows += top_matches[image_index][i].size();
+  }
+
+  std::vector<std::string> labels;
+  for ( std::map<std::string, boost::uint32_t>::iterator it =
+          label_ids.begin(); it != label_ids.end(); ++it )
+  {
+    it->second = labels.size();
+    labels.push_back(it->first);
+  }
+
+  // label index of every computed region, so the label column doesn't need
+  // a lookup per row
+  std::vector< std::vector<boost::uint32_t> > region_labels(images.size());
+  for ( size_t image_index = 0; image_index < images.size(); ++image_index )
+  {
+    const std::vector<std::string>& names =
+      computed_roi_list[image_index].labels;
+    region_labels[image_index].resize(names.size());
+    for ( size_t i = 0; i < names.size(); ++i )
+      region_labels[image_index][i] = label_ids[names[i]];
+  }
+
+  MatchDumpWriter out;
+  if ( !out.Open(path, rows, images, labels) )
+  {
+    std::cout << "Could not open " << path << std::endl;
+    return false;
+  }
+
+  // each column walks the matches in the same order
+  for ( int column = 0; column < MATCH_COLUMNS; ++column )
+  {
+    for ( size_t image_index = 0; image_index < top_matches.size();
+          ++image_index )
+    {
+      const std::vector< std::vector<IndexScore> >& image_matches =
+        top_matches[image_index];
+      for ( size_t truth = 0; truth < image_matches.size(); ++truth )
+        for ( size_t j = 0; j < image_matches[truth].size(); ++j )
+        {
+          const IndexScore& match = image_matches[truth][j];
+          switch ( column )
+          {
+            case MATCH_IMAGE:
+              out.Put(static_cast<boost::uint32_t>(image_index));
+              break;
+            case MATCH_TRUTH:
+              out.Put(static_cast<boost::uint32_t>(truth));
+              break;
+            case MATCH_COMPUTED:
+              out.Put(static_cast<boost::uint32_t>(match.index));
+              break;
+            case MATCH_IOU:
+              out.Put(match.score);
+              break;
+            case MATCH_SCORE:
+              out.Put(computed_roi_list[image_index].scores[match.index]);
+              break;
+            case MATCH_LABEL:
+              out.Put(region_labels[image_index][match.index]);
+              break;
+          }
+        }
+    }
+    out.EndColumn();
+  }
+
+  if ( !out.Close() )
+  {
+    std::cout << "Could not write " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void SaveLocalization(const std::vector<std::string>& labels,
+  const std::vector<LocalizationHistogram>& localization,
+  const Settings& program_settings)
+{
+  const fs::path& path = program_settings.localization_path;
+  if ( path.empty() )
+    return;
+
+  if ( path.has_parent_path() && !fs::exists(path.parent_path()) )
+    fs::create_directories(path.parent_path());
+  if ( !WriteLocalization(path, labels, localization) )
+    std::cout << "Could not write " << path << std::endl;
+}
+
+bool SaveResults(const std::vector<ImageRegionList>& computed_roi_list,
+  const std::vector< std::vector< std::vector<IndexScore> > >&
+  computed_roi_matches, const Settings& program_settings)
+{
+  const fs::path& path = program_settings.output_results_path;
+  if ( path.empty() )
+    return true;
+
+  // if output folder does not exist, create it
+  if ( path.has_parent_path() && !fs::exists(path.parent_path()) &&
+       !fs::create_directories(path.parent_path()) )
+  {
+    std::cout << "Could not create folder " << path.parent_path()
+              << std::endl;
+    return false;
+  }
+
+  BufferedWriter out;
+  if ( !out.Open(path) )
+  {
+    std::cout << "Could not open " << path << std::endl;
+    return false;
+  }
+
+  for ( size_t image_index = 0; image_index < computed_roi_list.size();
+        ++image_index )
+  {
+    const ImageRegionList& regions = computed_roi_list[image_index];
+    const std::vector< std::vector<IndexScore> >& matches =
+      computed_roi_matches[image_index];
+
+    // <image> <#roi> : <label> <score> <region> <TP/FP> <truth> <score> : ...
+    out.Write(regions.image_path.string()).Write(' ')
+       .Write(static_cast<long>(regions.regions.size()));
+    for ( size_t i = 0; i < regions.regions.size(); ++i )
+    {
+      out.Write(" : ").Write(regions.labels[i]).Write(' ')
+         .Write(regions.scores[i]).Write(' ');
+      WriteRegion(out, regions.regions[i], regions.shapes[i], true);
+
+      // matches are sorted so the first one is the best
+      if ( matches[i].empty() )
+        out.Write(" FP -1 0");
+      else
+        out.Write(" TP ").Write(static_cast<long>(matches[i][0].index))
+           .Write(' ').Write(matches[i][0].score);
+    }
+    out.Write('\n');
+  }
+
+  if ( !out.Close() )
+  {
+    std::cout << "Could not write " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/**ScalePoint******************************************************************\
+|   Description: Image coordinates of a point drawn on a reduced image         |
+\******************************************************************************/
+cv::Point ScalePoint(const cv::Point& point, double scale)
+{
+  return cv::Point(cvRound(point.x * scale), cvRound(point.y * scale));
+}
+
+/**DrawRegion******************************************************************\
+|   Description: Draw the outline of one region, coordinates are multiplied    |
+|                by scale to match an image decoded at reduced resolution      |
+\******************************************************************************/
+void DrawRegion(cv::Mat& img, const cv::Rect& roi, const RegionShape& shape,
+  const cv::Scalar& color, double scale)
+{
+  if ( shape.type == RegionShape::POLYGON && !shape.points.empty() )
+  {
+    std::vector<cv::Point> scaled(shape.points.size());
+    for ( size_t i = 0; i < scaled.size(); ++i )
+      scaled[i] = ScalePoint(shape.points[i], scale);
+
+    const cv::Point* points = &scaled[0];
+    int point_count = scaled.size();
+    cv::polylines(img, &points, &point_count, 1, true, color, 3, 8, 0);
+  }
+  else if ( shape.type == RegionShape::ELLIPSE )
+    cv::ellipse(img,
+                cv::RotatedRect(
+                  cv::Point2f(shape.ellipse.center.x * scale,
+                              shape.ellipse.center.y * scale),
+                  cv::Size2f(shape.ellipse.size.width * scale,
+                             shape.ellipse.size.height * scale),
+                  shape.ellipse.angle),
+                color, 3, 8);
+  else
+    cv::rectangle(img,
+                  ScalePoint(roi.tl(), scale),
+                  ScalePoint(roi.br(), scale),
+                  color,
+                  3,    // thickness TODO: add this as an option
+                  8,    // line type
+                  0);   // shift
+}
+
+/**DrawImage*******************************************************************\
+|   Description: Draw the true and computed regions of one image and a line    |
+|                from each computed region to every true region it matches,    |
+|                scale maps region coordinates to img                          |
+\******************************************************************************/
+void DrawImage(cv::Mat& img, const ImageRegionList& true_regions,
+  const ImageRegionList& computed_regions,
+  const std::vector< std::vector<IndexScore> >& matches, double scale)
+{
+  for ( size_t i = 0; i < true_regions.regions.size(); ++i )
+    DrawRegion(img,
+               true_regions.regions[i],
+               true_regions.shapes[i],
+               cv::Scalar(0,255,0),   // color
+               scale);
+
+  // draw rectangles and matching lines
+  for ( size_t i = 0; i < computed_regions.regions.size(); ++i )
+  {
+    // color of the rectangle, false positives are red, matched roi are blue
+    cv::Scalar rect_color;
+
+    if ( matches[i].size() == 0U )
+      rect_color = cv::Scalar(0,0,255);
+    else
+      rect_color = cv::Scalar(255,255,0);
+
+    DrawRegion(img, computed_regions.regions[i], computed_regions.shapes[i],
+               rect_color, scale);
+
+    // draw lines to matching regions
+    for ( size_t j = 0; j < matches[i].size(); ++j )
+    {
+      // the two rectangles to draw a line between
+      const cv::Rect true_roi = true_regions.regions[matches[i][j].index];
+      const cv::Rect comp_roi = computed_regions.regions[i];
+
+      const cv::Point true_center(true_roi.x + true_roi.width/2,
+                            true_roi.y + true_roi.height/2);
+      const cv::Point comp_center(comp_roi.x + comp_roi.width/2,
+                            comp_roi.y + comp_roi.height/2);
+
+      cv::line(
+        img,
+        ScalePoint(true_center, scale),
+        ScalePoint(comp_center, scale),
+        cv::Scalar(255,0,0),
+        3,
+        8,
+        0);
+    }
+  }
+}
+
+// an image moving through the DrawResults() pipeline
+struct DrawItem
+{
+  DrawItem() : index(0) {}
+  DrawItem(size_t i, const cv::Mat& m) : index(i), image(m) {}
+
+  size_t  index;  // index in the region lists
+  cv::Mat image;
+};
+
+// shared state of the DrawResults() pipeline, images are decoded, drawn on
+// and encoded by separate groups of threads connected by bounded queues
+struct DrawPipeline
+{
+  DrawPipeline(
+    const std::vector<ImageRegionList>&                         true_roi_list,
+    const std::vector<ImageRegionList>&                     computed_roi_list,
+    const std::vector< std::vector< std::vector<IndexScore> > >&
+                                                        computed_roi_matches,
+    const std::vector<bool>& reused, ImageCache& cache,
+    const fs::path& folder, int scale, int quality, size_t capacity,
+    int decoders, int drawers, ProgressBar& progress ) :
+    true_roi_list(true_roi_list), computed_roi_list(computed_roi_list),
+    computed_roi_matches(computed_roi_matches), reused(reused), cache(cache),
+    folder(folder), scale(scale), quality(quality), next(0),
+    progress(progress),
+    decoded(capacity, decoders), drawn(capacity, drawers)
+  {
+    parameters.push_back(cv::IMWRITE_JPEG_QUALITY);
+    parameters.push_back(quality);
+  }
+
+  // reads one image, empty if it can't be read
+  DrawItem Decode( size_t index )
+  {
+    return DrawItem(index, cache.Get(true_roi_list[index].image_path, scale,
+      index < reused.size() && reused[index]));
+  }
+
+  // draws the regions on a decoded image
+  void Draw( DrawItem& item )
+  {
+    // images that could not be read are passed on empty and not written
+    if ( !item.image.empty() )
+      DrawImage(item.image, true_roi_list[item.index],
+                computed_roi_list[item.index],
+                computed_roi_matches[item.index], 1.0 / scale);
+  }
+
+  // writes a drawn image
+  void Encode( const DrawItem& item )
+  {
+    const fs::path& original = true_roi_list[item.index].image_path;
+
+    // build image path as ...
+    // DRAW_RESULTS_FOLDER/ORIGINAL_BASENAME_analysis.ORIGINAL_EXTENSION
+    std::string image_name =
+      fs::basename(original.filename())+"_analysis";
+
+    fs::path image_path =
+      folder /
+      std::string(
+        image_name +
+        fs::extension(original)
+      );
+
+    // write the image
+    if ( !item.image.empty() )
+      imwrite(image_path.string(), item.image, parameters);
+    progress.add();
+  }
+
+  // every stage of one image on the calling thread, for ParallelFor() when
+  // there are too few threads for the pipeline
+  void operator()( size_t index, int )
+  {
+    DrawItem item = Decode(index);
+    Draw(item);
+    Encode(item);
+  }
+
+  const std::vector<ImageRegionList>&                           true_roi_list;
+  const std::vector<ImageRegionList>&                       computed_roi_list;
+  const std::vector< std::vector< std::vector<IndexScore> > >&
+                                                        computed_roi_matches;
+  const std::vector<bool>&  reused;   // images read again by SaveGallery()
+  ImageCache&               cache;
+  const fs::path&           folder;
+  int                       scale;    // images are reduced 1/scale
+  int                       quality;  // jpeg quality of the written images
+  std::vector<int>          parameters; // imwrite() parameters
+  boost::atomic<size_t>     next;     // next image to decode
+  ProgressBar&              progress; // counts the images written
+  BoundedQueue<DrawItem>    decoded;
+  BoundedQueue<DrawItem>    drawn;
+};
+
+// reads images in order until every image has been handed out.  The queue
+// after it lets decoding run ahead of drawing, so with the image cache this
+// also acts as the prefetcher of the draw loop.
+struct DecodeStage
+{
+  explicit DecodeStage( DrawPipeline& pipeline ) : pipeline(pipeline) {}
+
+  void operator()()
+  {
+    const size_t count = pipeline.true_roi_list.size();
+    for ( size_t index = pipeline.next++; index < count;
+          index = pipeline.next++ )
+      pipeline.decoded.Push(pipeline.Decode(index));
+    pipeline.decoded.ProducerDone();
+  }
+
+  DrawPipeline& pipeline;
+};
+
+// draws the regions of every decoded image
+struct DrawStage
+{
+  explicit DrawStage( DrawPipeline& pipeline ) : pipeline(pipeline) {}
+
+  void operator()()
+  {
+    DrawItem item;
+    while ( pipeline.decoded.Pop(item) )
+    {
+      pipeline.Draw(item);
+      pipeline.drawn.Push(item);
+    }
+    pipeline.drawn.ProducerDone();
+  }
+
+  DrawPipeline& pipeline;
+};
+
+// writes every drawn image
+struct EncodeStage
+{
+  explicit EncodeStage( DrawPipeline& pipeline ) : pipeline(pipeline) {}
+
+  void operator()()
+  {
+    DrawItem item;
+    while ( pipeline.drawn.Pop(item) )
+      pipeline.Encode(item);
+  }
+
+  DrawPipeline& pipeline;
+};
+
+// colours of DrawImage() as #rrggbb
+const char* const OVERLAY_TRUE_COLOR     = "#00ff00";
+const char* const OVERLAY_FALSE_COLOR    = "#ff0000";
+const char* const OVERLAY_MATCHED_COLOR  = "#00ffff";
+const char* const OVERLAY_LINE_COLOR     = "#0000ff";
+
+// writes text escaped for an xml attribute (svg) or a json string
+void WriteEscaped(BufferedWriter& out, const std::string& text, bool json)
+{
+  for ( size_t i = 0; i < text.size(); ++i )
+  {
+    char c = text[i];
+    if ( json && ( c == '"' || c == '\\' ) )
+      out.Write('\\').Write(c);
+    else if ( json && static_cast<unsigned char>(c) < 0x20 )
+      out.Write(' ');
+    else if ( !json && c == '&' )
+      out.Write("&amp;");
+    else if ( !json && c == '<' )
+      out.Write("&lt;");
+    else if ( !json && c == '"' )
+      out.Write("&quot;");
+    else
+      out.Write(c);
+  }
+}
+
+// writes one region as an svg element
+void WriteSvgRegion(BufferedWriter& out, const cv::Rect& roi,
+  const RegionShape& shape, const char* color)
+{
+  if ( shape.type == RegionShape::POLYGON && !shape.points.empty() )
+  {
+    out.Write("<polygon points=\"");
+    for ( size_t i = 0; i < shape.points.size(); ++i )
+      out.Write(static_cast<long>(shape.points[i].x)).Write(',')
+         .Write(static_cast<long>(shape.points[i].y))
+         .Write(i + 1 < shape.points.size() ? ' ' : '"');
+  }
+  else if ( shape.type == RegionShape::ELLIPSE )
+  {
+    const cv::RotatedRect& e = shape.ellipse;
+    out.Write("<ellipse cx=\"").Write(e.center.x)
+       .Write("\" cy=\"").Write(e.center.y)
+       .Write("\" rx=\"").Write(0.5 * e.size.width)
+       .Write("\" ry=\"").Write(0.5 * e.size.height)
+       .Write("\" transform=\"rotate(").Write(e.angle).Write(' ')
+       .Write(e.center.x).Write(' ').Write(e.center.y).Write(")\"");
+  }
+  else
+    out.Write("<rect x=\"").Write(static_cast<long>(roi.x))
+       .Write("\" y=\"").Write(static_cast<long>(roi.y))
+       .Write("\" width=\"").Write(static_cast<long>(roi.width))
+       .Write("\" height=\"").Write(static_cast<long>(roi.height))
+       .Write('"');
+  out.Write(" stroke=\"").Write(color).Write("\"/>\n");
+}
+
+// writes the geometry of one region as json members
+void WriteJsonRegion(BufferedWriter& out, const cv::Rect& roi,
+  const RegionShape& shape, const char* color)
+{
+  out.Write("\"color\":\"").Write(color).Write("\",");
+  if ( shape.type == RegionShape::POLYGON && !shape.points.empty() )
+  {
+    out.Write("\"polygon\":[");
+    for ( size_t i = 0; i < shape.points.size(); ++i )
+      out.Write(i > 0 ? ",[" : "[")
+         .Write(static_cast<long>(shape.points[i].x)).Write(',')
+         .Write(static_cast<long>(shape.points[i].y)).Write(']');
+    out.Write(']');
+  }
+  else if ( shape.type == RegionShape::ELLIPSE )
+  {
+    const cv::RotatedRect& e = shape.ellipse;
+    out.Write("\"ellipse\":[").Write(e.center.x).Write(',')
+       .Write(e.center.y).Write(',').Write(e.size.width).Write(',')
+       .Write(e.size.height).Write(',').Write(e.angle).Write(']');
+  }
+  else
+    out.Write("\"rect\":[").Write(static_cast<long>(roi.x)).Write(',')
+       .Write(static_cast<long>(roi.y)).Write(',')
+       .Write(static_cast<long>(roi.width)).Write(',')
+       .Write(static_cast<long>(roi.height)).Write(']');
+}
+
+// writes the overlay of one image, used with ParallelFor() by DrawResults().
+// Holds one writer per thread so files are written without allocating.
+struct OverlayImage
+{
+  OverlayImage(
+    const std::vector<ImageRegionList>&                         true_roi_list,
+    const std::vector<ImageRegionList>&                     computed_roi_list,
+    const std::vector< std::vector< std::vector<IndexScore> > >&
+                                                        computed_roi_matches,
+    const fs::path& folder, bool json, BufferedWriter* writers,
+    ProgressBar& progress ) :
+    true_roi_list(true_roi_list), computed_roi_list(computed_roi_list),
+    computed_roi_matches(computed_roi_matches), folder(folder), json(json),
+    writers(writers), progress(progress) {}
+
+  void operator()( size_t index, int thread )
+  {
+    const ImageRegionList& true_regions = true_roi_list[index];
+    const ImageRegionList& computed_regions = computed_roi_list[index];
+    const std::vector< std::vector<IndexScore> >& matches =
+      computed_roi_matches[index];
+
+    // same name as the drawn image with the overlay extension
+    fs::path path = folder / std::string(
+      fs::basename(true_regions.image_path.filename()) + "_analysis" +
+      ( json ? ".json" : ".svg" ));
+
+    BufferedWriter& out = writers[thread];
+    if ( out.Open(path) )
+    {
+      if ( json )
+        WriteJson(out, true_regions, computed_regions, matches);
+      else
+        WriteSvg(out, true_regions, computed_regions, matches);
+      out.Close();
+    }
+    progress.add();
+  }
+
+  // coordinates are in pixels of the original image
+  void WriteSvg( BufferedWriter& out, const ImageRegionList& true_regions,
+    const ImageRegionList& computed_regions,
+    const std::vector< std::vector<IndexScore> >& matches )
+  {
+    out.Write("<svg xmlns=\"http://www.w3.org/2000/svg\" data-image=\"");
+    WriteEscaped(out, true_regions.image_path.string(), false);
+    out.Write("\" overflow=\"visible\" fill=\"none\" "
+              "stroke-width=\"3\">\n");
+
+    for ( size_t i = 0; i < true_regions.regions.size(); ++i )
+      WriteSvgRegion(out, true_regions.regions[i], true_regions.shapes[i],
+                     OVERLAY_TRUE_COLOR);
+
+    for ( size_t i = 0; i < computed_regions.regions.size(); ++i )
+    {
+      WriteSvgRegion(out, computed_regions.regions[i],
+                     computed_regions.shapes[i], matches[i].empty() ?
+                     OVERLAY_FALSE_COLOR : OVERLAY_MATCHED_COLOR);
+
+      const cv::Rect& comp_roi = computed_regions.regions[i];
+      for ( size_t j = 0; j < matches[i].size(); ++j )
+      {
+        const cv::Rect& true_roi = true_regions.regions[matches[i][j].index];
+        out.Write("<line x1=\"")
+           .Write(static_cast<long>(true_roi.x + true_roi.width/2))
+           .Write("\" y1=\"")
+           .Write(static_cast<long>(true_roi.y + true_roi.height/2))
+           .Write("\" x2=\"")
+           .Write(static_cast<long>(comp_roi.x + comp_roi.width/2))
+           .Write("\" y2=\"")
+           .Write(static_cast<long>(comp_roi.y + comp_roi.height/2))
+           .Write("\" stroke=\"").Write(OVERLAY_LINE_COLOR).Write("\"/>\n");
+      }
+    }
+    out.Write("</svg>\n");
+  }
+
+  // {"image", "truth": [...], "computed": [...], "lines": [...]}
+  void WriteJson( BufferedWriter& out, const ImageRegionList& true_regions,
+    const ImageRegionList& computed_regions,
+    const std::vector< std::vector<IndexScore> >& matches )
+  {
+    out.Write("{\"image\":\"");
+    WriteEscaped(out, true_regions.image_path.string(), true);
+
+    out.Write("\",\n\"truth\":[");
+    for ( size_t i = 0; i < true_regions.regions.size(); ++i )
+    {
+      out.Write(i > 0 ? ",\n{\"label\":\"" : "\n{\"label\":\"");
+      WriteEscaped(out, true_regions.labels[i], true);
+      out.Write("\",");
+      WriteJsonRegion(out, true_regions.regions[i], true_regions.shapes[i],
+                      OVERLAY_TRUE_COLOR);
+      out.Write('}');
+    }
+
+    out.Write("],\n\"computed\":[");
+    for ( size_t i = 0; i < computed_regions.regions.size(); ++i )
+    {
+      out.Write(i > 0 ? ",\n{\"label\":\"" : "\n{\"label\":\"");
+      WriteEscaped(out, computed_regions.labels[i], true);
+      out.Write("\",\"score\":").Write(computed_regions.scores[i])
+         .Write(",\"matched\":").Write(matches[i].empty() ? "false" : "true")
+         .Write(',');
+      WriteJsonRegion(out, computed_regions.regions[i],
+                      computed_regions.shapes[i], matches[i].empty() ?
+                      OVERLAY_FALSE_COLOR : OVERLAY_MATCHED_COLOR);
+      out.Write('}');
+    }
+
+    out.Write("],\n\"lines\":[");
+    bool first = true;
+    for ( size_t i = 0; i < computed_regions.regions.size(); ++i )
+    {
+      const cv::Rect& comp_roi = computed_regions.regions[i];
+      for ( size_t j = 0; j < matches[i].size(); ++j )
+      {
+        const cv::Rect& true_roi = true_regions.regions[matches[i][j].index];
+        out.Write(first ? "\n{\"truth\":" : ",\n{\"truth\":")
+           .Write(static_cast<long>(matches[i][j].index))
+           .Write(",\"computed\":").Write(static_cast<long>(i))
+           .Write(",\"overlap\":").Write(matches[i][j].score)
+           .Write(",\"color\":\"").Write(OVERLAY_LINE_COLOR)
+           .Write("\",\"points\":[")
+           .Write(static_cast<long>(true_roi.x + true_roi.width/2)).Write(',')
+           .Write(static_cast<long>(true_roi.y + true_roi.height/2)).Write(',')
+           .Write(static_cast<long>(comp_roi.x + comp_roi.width/2)).Write(',')
+           .Write(static_cast<long>(comp_roi.y + comp_roi.height/2))
+           .Write("]}");
+        first = false;
+      }
+    }
+    out.Write("]}\n");
+  }
+
+  const std::vector<ImageRegionList>&                           true_roi_list;
+  const std::vector<ImageRegionList>&                       computed_roi_list;
+  const std::vector< std::vector< std::vector<IndexScore> > >&
+                                                        computed_roi_matches;
+  const fs::path&       folder;
+  bool                  json;
+  BufferedWriter*       writers;
+  ProgressBar&          progress;
+};
+
 void DrawResults(const std::vector<ImageRegionList>& true_roi_list,
   const std::vector<ImageRegionList>& computed_roi_list,
   const std::vector< std::vector< std::vector<IndexScore> > >& 
-  computed_roi_matches, const Settings& program_settings)
+  computed_roi_matches, const Settings& program_settings,
+  const std::vector<bool>& gallery_images, ImageCache& image_cache)
 {
   if ( !program_settings.draw_results )
     return;
@@ -447,116 +1824,339 @@ void DrawResults(const std::vector<ImageRegionList>& true_roi_list,
       return;
     }
   }
-  
-  // iterator typedefs
-  typedef std::vector<ImageRegionList>::const_iterator
-          ConstRegionIterator;
 
-  typedef std::vector<cv::Rect>::const_iterator
-          ConstRectIterator;
-  
-  typedef std::vector< std::vector< std::vector<IndexScore> > >::const_iterator
-          Vector3DIterator;
-
-  typedef std::vector< std::vector<IndexScore> >::const_iterator
-          Vector2DIterator;
-
-  typedef std::vector<IndexScore>::const_iterator
-          IndexScoreIterator;
+  const int count = static_cast<int>(true_roi_list.size());
 
   ProgressBar progress_bar(
     cout,
     "Drawing Results ",
-    static_cast<int>(true_roi_list.size()),
+    count,
     60
   );
 
-  int progress = 0;
+  int threads = ThreadCount(program_settings.num_threads);
 
-  // draw the progress bar
-  progress_bar.update(progress);
+  // overlays only need the regions, the images are never read
+  if ( program_settings.draw_format != Settings::DRAW_IMAGE )
+  {
+    boost::scoped_array<BufferedWriter> writers(
+      new BufferedWriter[threads]);
+    OverlayImage overlay(true_roi_list, computed_roi_list,
+                         computed_roi_matches,
+                         program_settings.draw_results_folder,
+                         program_settings.draw_format == Settings::DRAW_JSON,
+                         writers.get(), progress_bar);
+    ParallelFor(count, threads, overlay);
+    progress_bar.finish();
+    return;
+  }
 
-  // draw rectangles on each image
-  ConstRegionIterator true_roi_it = true_roi_list.begin();
-  ConstRegionIterator computed_roi_it = computed_roi_list.begin();
-  Vector3DIterator computed_matches_it = computed_roi_matches.begin();
-  for ( ; true_roi_it != true_roi_list.end();
-          ++true_roi_it, ++computed_roi_it, ++computed_matches_it )
+  // decoding and encoding dominate, drawing only needs a few threads.  The
+  // num_threads threads are split a quarter drawing and the rest evenly
+  // between decoding and encoding, with at least one thread per stage.  Each
+  // queue holds at most one image per thread so memory stays bounded on
+  // large images.  With fewer than 3 threads every thread runs all three
+  // stages on its own images instead.
+  int drawers = std::max(1, threads / 4);
+  int decoders = std::max(1, ( threads - drawers ) / 2);
+  int encoders = std::max(1, threads - drawers - decoders);
+  DrawPipeline pipeline(true_roi_list, computed_roi_list,
+                        computed_roi_matches, gallery_images, image_cache,
+                        program_settings.draw_results_folder,
+                        std::max(1, program_settings.draw_scale),
+                        program_settings.draw_quality, threads, decoders,
+                        drawers, progress_bar);
+  if ( threads < 3 )
   {
-    cv::Mat img = cv::imread(true_roi_it->image_path.string());
-    
-    ConstRectIterator true_regions_it = true_roi_it->regions.begin();
-    ConstRectIterator true_regions_end = true_roi_it->regions.end();
-    for ( ; true_regions_it != true_regions_end; ++true_regions_it )
-      cv::rectangle(img,
-                    *true_regions_it,
-                    cv::Scalar(0,255,0),  // color
-                    3,    // thickness TODO: add this as an option
-                    8,    // line type
-                    0);   // shift
-
-    // draw rectangles and matching lines
-    ConstRectIterator computed_regions_it = computed_roi_it->regions.begin();
-    ConstRectIterator computed_regions_end = computed_roi_it->regions.end();
-    Vector2DIterator matching_list_it = computed_matches_it->begin();
-    for ( ; computed_regions_it != computed_regions_end;
-          ++computed_regions_it, ++matching_list_it )
+    ParallelFor(count, threads, pipeline);
+    progress_bar.finish();
+    return;
+  }
+
+  boost::thread_group workers;
+  for ( int i = 0; i < decoders; ++i )
+    workers.create_thread(DecodeStage(pipeline));
+  for ( int i = 0; i < encoders; ++i )
+    workers.create_thread(EncodeStage(pipeline));
+  for ( int i = 0; i < drawers; ++i )
+    workers.create_thread(DrawStage(pipeline));
+  workers.join_all();
+  progress_bar.finish();
+}
+
+// an error cropped into the gallery
+struct GalleryChip
+{
+  GalleryChip() {}
+  GalleryChip(size_t i, size_t r, bool m, double k) :
+    image(i), region(r), missed(m), key(k), sheet(0), cell(0) {}
+
+  size_t  image;    // index in the region lists
+  size_t  region;   // index of the computed (FP) or true (FN) region
+  bool    missed;   // true for a missed ground truth
+  double  key;      // detection score (FP) or best overlap (FN)
+  int     sheet;    // index in the list of sheets
+  int     cell;     // position on the sheet, row major
+};
+
+// orders chips from the highest key down
+bool ChipOrder(const GalleryChip& lhs, const GalleryChip& rhs)
+{ return lhs.key > rhs.key; }
+
+// every false positive then every missed ground truth in image order,
+// returns the number of false positives
+size_t GalleryChips(const std::vector<ImageRegionList>& computed_roi_list,
+  const std::vector< std::vector< std::vector<IndexScore> > >& top_matches,
+  const std::vector< std::vector< std::vector<IndexScore> > >&
+  computed_roi_matches, double overlap_threshold,
+  std::vector<GalleryChip>& chips)
+{
+  chips.clear();
+  for ( size_t image_index = 0; image_index < computed_roi_matches.size();
+        ++image_index )
+    for ( size_t i = 0; i < computed_roi_matches[image_index].size(); ++i )
+      if ( computed_roi_matches[image_index][i].empty() )
+        chips.push_back(GalleryChip(image_index, i, false,
+          computed_roi_list[image_index].scores[i]));
+  const size_t false_positives = chips.size();
+
+  for ( size_t image_index = 0; image_index < top_matches.size();
+        ++image_index )
+    for ( size_t i = 0; i < top_matches[image_index].size(); ++i )
     {
-      // color of the rectangle, false positives are red, matched roi are blue
-      cv::Scalar rect_color;
+      const std::vector<IndexScore>& matches = top_matches[image_index][i];
+      double best = matches.empty() ? 0.0 : matches[0].score;
+      if ( best <= overlap_threshold )
+        chips.push_back(GalleryChip(image_index, i, true, best));
+    }
+  return false_positives;
+}
 
-      if ( matching_list_it->size() == 0U )
-        rect_color = cv::Scalar(0,0,255);
-      else
-        rect_color = cv::Scalar(255,255,0);
-
-      cv::rectangle(img,
-                   *computed_regions_it,
-                    rect_color,
-                    3,
-                    8,
-                    0);
-
-      // draw lines to matching regions
-      for ( IndexScoreIterator match_roi_it = matching_list_it->begin();
-            match_roi_it != matching_list_it->end(); ++match_roi_it )
-      {
-        // the two rectangles to draw a line between
-        const cv::Rect true_roi = true_roi_it->regions[match_roi_it->index];
-        const cv::Rect comp_roi = *computed_regions_it;
-
-        const cv::Point true_center(true_roi.x + true_roi.width/2,
-                              true_roi.y + true_roi.height/2);
-        const cv::Point comp_center(comp_roi.x + comp_roi.width/2,
-                              comp_roi.y + comp_roi.height/2);
-
-        cv::line(
-          img,
-          true_center,
-          comp_center,
-          cv::Scalar(255,0,0),
-          3,
-          8,
-          0);
-      }
-    } 
+// the gallery reads images at the scale DrawResults() decodes them at, so
+// both share the cached images
+int GalleryScale(const Settings& program_settings)
+{
+  if ( program_settings.draw_results &&
+       program_settings.draw_format == Settings::DRAW_IMAGE )
+    return std::max(1, program_settings.draw_scale);
+  return 1;
+}
 
-    // build image path as ...
-    // DRAW_RESULTS_FOLDER/ORIGINAL_BASENAME_analysis.ORIGINAL_EXTENSION
-    std::string image_name =
-      fs::basename(true_roi_it->image_path.filename())+"_analysis";
-    
-    fs::path image_path =
-      program_settings.draw_results_folder /
-      std::string(
-        image_name +
-        fs::extension(true_roi_it->image_path)
-      );
+// crops the chips of one image into their sheets, used with ParallelFor() by
+// SaveGallery().  Every chip has its own cell so threads never write the
+// same pixels.
+struct GalleryImage
+{
+  GalleryImage(
+    const std::vector<ImageRegionList>&                         true_roi_list,
+    const std::vector<ImageRegionList>&                     computed_roi_list,
+    const std::vector< std::vector< std::vector<IndexScore> > >&
+                                                        computed_roi_matches,
+    const std::vector<GalleryChip>& chips,
+    const std::vector< std::vector<size_t> >& image_chips,
+    const std::vector<size_t>& images, std::vector<cv::Mat>& sheets,
+    ImageCache& cache, int scale, int chip_size, int grid, double padding ) :
+    true_roi_list(true_roi_list), computed_roi_list(computed_roi_list),
+    computed_roi_matches(computed_roi_matches), chips(chips),
+    image_chips(image_chips), images(images), sheets(sheets), cache(cache),
+    scale(scale), chip_size(chip_size), grid(grid), padding(padding) {}
+
+  void operator()( size_t index, int /*thread*/ )
+  {
+    const size_t image_index = images[index];
+    cv::Mat img = cache.Get(true_roi_list[image_index].image_path, scale,
+                            false);
+    if ( img.empty() )
+      return;
 
-    // write the image
-    imwrite(image_path.string(), img);
+    // chips show the same outlines as DrawResults()
+    DrawImage(img, true_roi_list[image_index], computed_roi_list[image_index],
+              computed_roi_matches[image_index], 1.0 / scale);
 
-    progress_bar.update(progress++);
+    const cv::Rect bounds(0, 0, img.cols, img.rows);
+    const std::vector<size_t>& list = image_chips[image_index];
+    for ( size_t i = 0; i < list.size(); ++i )
+    {
+      const GalleryChip& chip = chips[list[i]];
+      const cv::Rect& region = chip.missed ?
+        true_roi_list[image_index].regions[chip.region] :
+        computed_roi_list[image_index].regions[chip.region];
+      const cv::Rect roi(ScalePoint(region.tl(), 1.0 / scale),
+                         ScalePoint(region.br(), 1.0 / scale));
+
+      // padded crop, clipped to the image
+      int pad = cvRound(padding * std::max(roi.width, roi.height));
+      cv::Rect crop = cv::Rect(roi.x - pad, roi.y - pad,
+                               roi.width + 2 * pad, roi.height + 2 * pad) &
+                      bounds;
+      if ( crop.width <= 0 || crop.height <= 0 )
+        continue;
+
+      // fit the crop in its cell keeping the aspect ratio, centered
+      double scale = static_cast<double>(chip_size) /
+                     std::max(crop.width, crop.height);
+      cv::Size size(std::max(1, cvRound(crop.width * scale)),
+                    std::max(1, cvRound(crop.height * scale)));
+      cv::Rect cell((chip.cell % grid) * chip_size +
+                      (chip_size - size.width) / 2,
+                    (chip.cell / grid) * chip_size +
+                      (chip_size - size.height) / 2,
+                    size.width, size.height);
+      cv::Mat target = sheets[chip.sheet](cell);
+      cv::resize(img(crop), target, size, 0, 0, cv::INTER_AREA);
+    }
+  }
+
+  const std::vector<ImageRegionList>&                           true_roi_list;
+  const std::vector<ImageRegionList>&                       computed_roi_list;
+  const std::vector< std::vector< std::vector<IndexScore> > >&
+                                                        computed_roi_matches;
+  const std::vector<GalleryChip>&           chips;
+  const std::vector< std::vector<size_t> >& image_chips;
+  const std::vector<size_t>&                images;
+  std::vector<cv::Mat>&                     sheets;
+  ImageCache&                               cache;
+  int                                       scale;  // images are 1/scale
+  int                                       chip_size;
+  int                                       grid;
+  double                                    padding;
+};
+
+// writes one sheet, used with ParallelFor() by SaveGallery()
+struct GallerySheet
+{
+  GallerySheet( const std::vector<cv::Mat>& sheets,
+    const std::vector<fs::path>& paths ) : sheets(sheets), paths(paths) {}
+
+  void operator()( size_t index, int /*thread*/ )
+  {
+    imwrite(paths[index].string(), sheets[index]);
   }
+
+  const std::vector<cv::Mat>&   sheets;
+  const std::vector<fs::path>&  paths;
+};
+
+void GalleryImages(const std::vector<ImageRegionList>& computed_roi_list,
+  const std::vector< std::vector< std::vector<IndexScore> > >& top_matches,
+  const std::vector< std::vector< std::vector<IndexScore> > >&
+  computed_roi_matches, const Settings& program_settings,
+  std::vector<bool>& images)
+{
+  images.clear();
+  if ( program_settings.gallery_folder.empty() )
+    return;
+
+  std::vector<GalleryChip> chips;
+  GalleryChips(computed_roi_list, top_matches, computed_roi_matches,
+               program_settings.overlap_threshold, chips);
+  images.assign(top_matches.size(), false);
+  for ( size_t i = 0; i < chips.size(); ++i )
+    images[chips[i].image] = true;
 }
 
+void SaveGallery(const std::vector<ImageRegionList>& true_roi_list,
+  const std::vector<ImageRegionList>& computed_roi_list,
+  const std::vector< std::vector< std::vector<IndexScore> > >& top_matches,
+  const std::vector< std::vector< std::vector<IndexScore> > >&
+  computed_roi_matches, const Settings& program_settings,
+  ImageCache& image_cache)
+{
+  const fs::path& folder = program_settings.gallery_folder;
+  if ( folder.empty() )
+    return;
+
+  if ( !fs::exists(folder) && !fs::create_directories(folder) )
+  {
+    std::cout << "Could not create folder " << folder << std::endl;
+    return;
+  }
+
+  const int chip_size = std::max(1, program_settings.gallery_chip_size);
+  const int grid = std::max(1, program_settings.gallery_grid);
+  const int per_sheet = grid * grid;
+
+  std::vector<GalleryChip> chips;
+  const size_t false_positives = GalleryChips(computed_roi_list, top_matches,
+    computed_roi_matches, program_settings.overlap_threshold, chips);
+
+  std::stable_sort(chips.begin(), chips.begin() + false_positives, ChipOrder);
+  std::stable_sort(chips.begin() + false_positives, chips.end(), ChipOrder);
+
+  // place the chips, each kind starts on a new sheet
+  std::vector<fs::path> paths;
+  std::vector< std::vector<size_t> > image_chips(true_roi_list.size());
+  for ( size_t i = 0; i < chips.size(); ++i )
+  {
+    bool missed = chips[i].missed;
+    size_t position = missed ? i - false_positives : i;
+    if ( position % per_sheet == 0 )
+    {
+      std::ostringstream name;
+      name << ( missed ? "fn_" : "fp_" ) << std::setw(3) << std::setfill('0')
+           << position / per_sheet << ".jpg";
+      paths.push_back(folder / name.str());
+    }
+    chips[i].sheet = paths.size() - 1;
+    chips[i].cell = position % per_sheet;
+    image_chips[chips[i].image].push_back(i);
+  }
+
+  // only images with errors are read, the latest drawn first since those
+  // are the ones still in the memory cache
+  std::vector<size_t> images;
+  for ( size_t i = image_chips.size(); i-- > 0; )
+    if ( !image_chips[i].empty() )
+      images.push_back(i);
+
+  std::vector<cv::Mat> sheets(paths.size());
+  for ( size_t i = 0; i < sheets.size(); ++i )
+    sheets[i] = cv::Mat(grid * chip_size, grid * chip_size, CV_8UC3,
+                        cv::Scalar(0,0,0));
+
+  int threads = ThreadCount(program_settings.num_threads);
+  GalleryImage gallery_image(true_roi_list, computed_roi_list,
+                             computed_roi_matches, chips, image_chips, images,
+                             sheets, image_cache,
+                             GalleryScale(program_settings), chip_size, grid,
+                             program_settings.gallery_padding);
+  ParallelFor(images.size(), threads, gallery_image);
+
+  GallerySheet gallery_sheet(sheets, paths);
+  ParallelFor(sheets.size(), threads, gallery_sheet);
+
+  // sidecar index of every chip
+  fs::path index_path = folder / "index.csv";
+  BufferedWriter out;
+  bool written = out.Open(index_path);
+  if ( written )
+  {
+    out.Write("sheet,row,column,type,image,region,score,overlap\n");
+    for ( size_t i = 0; i < chips.size(); ++i )
+    {
+      const GalleryChip& chip = chips[i];
+      out.Write(paths[chip.sheet].filename().string()).Write(',')
+         .Write(static_cast<long>(chip.cell / grid)).Write(',')
+         .Write(static_cast<long>(chip.cell % grid)).Write(',')
+         .Write(chip.missed ? "FN" : "FP").Write(',')
+         .Write(true_roi_list[chip.image].image_path.string()).Write(',')
+         .Write(static_cast<long>(chip.region)).Write(',');
+
+      // a miss is listed with the score of its best overlapping region, if any
+      if ( !chip.missed )
+        out.Write(chip.key).Write(',');
+      else
+      {
+        const std::vector<IndexScore>& matches =
+          top_matches[chip.image][chip.region];
+        if ( !matches.empty() )
+          out.Write(computed_roi_list[chip.image].scores[matches[0].index]);
+        out.Write(',').Write(chip.key);
+      }
+      out.Write('\n');
+    }
+    written = out.Close();
+  }
+  if ( !written )
+    std::cout << "Could not write " << index_path << std::endl;
+}
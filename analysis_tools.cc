@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cmath>
+#include <boost/thread/tss.hpp>
 #include "analysis_tools.h"
 
 namespace analysis_tools
@@ -39,63 +42,734 @@ double computeScore(const Rect& r1, const Rect& r2)
   return intersectArea/unionArea;
 }
 
+Rect boundingBox(const Point* points, int count)
+{
+  if ( count <= 0 )
+    return Rect();
+
+  float minX = points[0].x, maxX = points[0].x,
+        minY = points[0].y, maxY = points[0].y;
+  for ( int i = 1; i < count; ++i )
+  {
+    minX = min(minX,points[i].x);
+    maxX = max(maxX,points[i].x);
+    minY = min(minY,points[i].y);
+    maxY = max(maxY,points[i].y);
+  }
+  return Rect(minX,minY,maxX-minX,maxY-minY);
+}
+
+// scratch space for the overloads called without a ScoreContext
+ScoreContext& threadContext()
+{
+  static boost::thread_specific_ptr<ScoreContext> context;
+  if ( !context.get() )
+    context.reset(new ScoreContext);
+  return *context;
+}
+
 double computeScore(const vector<Point>& polygon1, const vector<Point>& polygon2)
 {
-  // convert the vectors to arrays of Points
+  return computeScore(polygon1,polygon2,threadContext());
+}
+
+double computeScore(const clipper::Polygon& polygon1, const clipper::Polygon& polygon2)
+{
+  return computeScore(polygon1,polygon2,threadContext());
+}
+
+double computeScore(const vector<Point>& polygon1, const vector<Point>& polygon2,
+  ScoreContext& context)
+{
+  if ( isConvex(polygon1) && isConvex(polygon2) )
+    return computeConvexScore(polygon1,polygon2);
+
+  // convert the vectors to clipper polygons (reusing the context's buffers)
   int p1_size = polygon1.size(),
       p2_size = polygon2.size();
 
-  clipper::Polygon poly1(polygon1.size()), poly2(polygon2.size());
+  context.polygon1.resize(p1_size);
+  context.polygon2.resize(p2_size);
   
   for( int i = 0; i < p1_size; i++ )
-    cvt(polygon1[i],poly1[i]);
+    cvt(polygon1[i],context.polygon1[i]);
   for( int i = 0; i < p2_size; i++ )
-    cvt(polygon2[i],poly2[i]);
+    cvt(polygon2[i],context.polygon2[i]);
 
-  // call the other compute score function
-  return computeScore(poly1,poly2);
+  // inputs are known not to be both convex
+  return computeClipperScore(context.polygon1,context.polygon2,context);
 }
 
-// pts is the number of contours in each polygon respectively (i.e., length of array)
-double computeScore(const clipper::Polygon& polygon1, const clipper::Polygon& polygon2)
+double computeScore(const clipper::Polygon& polygon1,
+  const clipper::Polygon& polygon2, ScoreContext& context)
+{
+  if ( isConvex(polygon1) && isConvex(polygon2) )
+    return computeConvexScore(polygon1,polygon2);
+  return computeClipperScore(polygon1,polygon2,context);
+}
+
+// true if the polygon can be clipped with 32 bit coordinates
+bool fitsClipper32(const clipper::Polygon& polygon)
+{
+  for ( size_t i = 0; i < polygon.size(); ++i )
+    if ( polygon[i].X < -clipper::Clipper32Range ||
+         polygon[i].X > clipper::Clipper32Range ||
+         polygon[i].Y < -clipper::Clipper32Range ||
+         polygon[i].Y > clipper::Clipper32Range )
+      return false;
+  return true;
+}
+
+// area of the intersection using either clipper, returns false if the
+// clipper fails
+template <class ClipperType>
+bool intersectionArea(ClipperType& c, const clipper::Polygon& polygon1,
+  const clipper::Polygon& polygon2, double& area)
 {
-  static clipper::Clipper c;
   c.Clear();
   
-  clipper::Polygons solution;
-  
   c.AddPolygon(polygon1,clipper::ptSubject);
   c.AddPolygon(polygon2,clipper::ptClip);
-  if ( !c.Execute(clipper::ctIntersection,solution) )
+
+  // only the area of the intersection is needed, not its outline
+  return c.ExecuteArea(clipper::ctIntersection,area);
+}
+
+// same as above with prepared edges as the subject
+template <class ClipperType, class PreparedType>
+bool intersectionArea(ClipperType& c, PreparedType& prepared,
+  const clipper::Polygon& polygon, double& area)
+{
+  c.Clear();
+  c.AddPrepared(prepared,clipper::ptSubject);
+  c.AddPolygon(polygon,clipper::ptClip);
+  return c.ExecuteArea(clipper::ctIntersection,area);
+}
+
+double computeClipperScore(const clipper::Polygon& polygon1,
+  const clipper::Polygon& polygon2, ScoreContext& context)
+{
+  // image coordinates nearly always fit the cheaper 32 bit clipper
+  double polyIntersect;
+  bool clipped = fitsClipper32(polygon1) && fitsClipper32(polygon2) ?
+    intersectionArea(context.clipper32,polygon1,polygon2,polyIntersect) :
+    intersectionArea(context.clipper,polygon1,polygon2,polyIntersect);
+  if ( !clipped )
     return 0;
 
-  double polyIntersect = 0.0;
+  // the input orientation is arbitrary so only the magnitudes are meaningful
+  double polyUnion = fabs(clipper::Area(polygon1,false)) +
+    fabs(clipper::Area(polygon2,false)) - polyIntersect;
+
+  return polyIntersect / polyUnion;
+}
+
+// convex polygon kernel
+//
+// Points are converted to doubles the same way cvt() converts them for the
+// clipper (truncated to integers) so both paths score the same polygons.
+
+struct ConvexPoint
+{
+  double x, y;
+};
+
+// largest polygon used in place of an ellipse
+const int MAX_ELLIPSE_POINTS = 64;
+
+// clipping adds at most one point per edge of the clip polygon, the largest
+// pair is two ellipses
+const int MAX_CLIP_POINTS = 2*MAX_ELLIPSE_POINTS;
+
+inline void toConvex(const Point& p1, ConvexPoint& p2)
+{
+  p2.x = (double)(clipper::long64)p1.x;
+  p2.y = (double)(clipper::long64)p1.y;
+}
+
+inline void toConvex(const clipper::IntPoint& p1, ConvexPoint& p2)
+{
+  p2.x = (double)p1.X;
+  p2.y = (double)p1.Y;
+}
+
+inline double cross(const ConvexPoint& o, const ConvexPoint& a,
+  const ConvexPoint& b)
+{
+  return (a.x-o.x)*(b.y-o.y) - (a.y-o.y)*(b.x-o.x);
+}
+
+// twice the signed area
+double doubleArea(const ConvexPoint* pts, int n)
+{
+  double a = 0.0;
+  for ( int i = 0, j = n-1; i < n; j = i++ )
+    a += pts[j].x*pts[i].y - pts[i].x*pts[j].y;
+  return a;
+}
+
+// copies a polygon into a fixed buffer, returns the number of points
+template <typename P>
+int loadConvex(const vector<P>& polygon, ConvexPoint* pts)
+{
+  int n = polygon.size();
+  for ( int i = 0; i < n; ++i )
+    toConvex(polygon[i],pts[i]);
+  return n;
+}
+
+// every turn goes the same way and the outline winds around only once (the
+// direction of travel along each axis changes sign at most twice), repeated
+// points and collinear points are allowed
+template <typename P>
+bool convexPolygon(const vector<P>& polygon)
+{
+  int n = polygon.size();
+  if ( n < 3 || n > MAX_CONVEX_POINTS )
+    return false;
+
+  ConvexPoint pts[MAX_CONVEX_POINTS];
+  loadConvex(polygon,pts);
+
+  int turn = 0, xFlips = 0, yFlips = 0;
+  double lastDx = 0.0, lastDy = 0.0, firstDx = 0.0, firstDy = 0.0;
+  bool first = true;
+  for ( int i = 0; i < n; ++i )
+  {
+    const ConvexPoint& a = pts[i];
+    const ConvexPoint& b = pts[(i+1)%n];
+    const ConvexPoint& c = pts[(i+2)%n];
+
+    double z = cross(a,b,c);
+    if ( z != 0.0 )
+    {
+      int sign = z > 0.0 ? 1 : -1;
+      if ( turn == 0 )
+        turn = sign;
+      else if ( turn != sign )
+        return false;
+    }
+
+    double dx = b.x-a.x, dy = b.y-a.y;
+    if ( first )
+    {
+      firstDx = dx;
+      firstDy = dy;
+      first = false;
+    }
+    else
+    {
+      if ( dx != 0.0 && lastDx != 0.0 && (dx > 0.0) != (lastDx > 0.0) )
+        ++xFlips;
+      if ( dy != 0.0 && lastDy != 0.0 && (dy > 0.0) != (lastDy > 0.0) )
+        ++yFlips;
+    }
+    if ( dx != 0.0 ) lastDx = dx;
+    if ( dy != 0.0 ) lastDy = dy;
+  }
+
+  // close the loop
+  if ( firstDx != 0.0 && lastDx != 0.0 && (firstDx > 0.0) != (lastDx > 0.0) )
+    ++xFlips;
+  if ( firstDy != 0.0 && lastDy != 0.0 && (firstDy > 0.0) != (lastDy > 0.0) )
+    ++yFlips;
 
-  for ( clipper::Polygons::iterator i = solution.begin(); i != solution.end(); ++i )
-    polyIntersect += clipper::Area(*i,false);
+  return turn != 0 && xFlips <= 2 && yFlips <= 2;
+}
+
+bool isConvex(const vector<Point>& polygon)
+{
+  return convexPolygon(polygon);
+}
 
-  double polyUnion = clipper::Area(polygon1,false) + clipper::Area(polygon2,false) -
-    polyIntersect;
+bool isConvex(const clipper::Polygon& polygon)
+{
+  return convexPolygon(polygon);
+}
+
+// area of the intersection of two convex polygons, the subject is clipped
+// against each edge of the clip polygon in turn. Each edge adds at most one
+// point so MAX_CLIP_POINTS is always enough room.
+double convexIntersectArea(const ConvexPoint* subject, int n,
+  const ConvexPoint* clip, int m)
+{
+  ConvexPoint buffer1[MAX_CLIP_POINTS], buffer2[MAX_CLIP_POINTS];
+  ConvexPoint *in = buffer1, *out = buffer2;
+
+  double orientation = doubleArea(clip,m);
+  if ( orientation == 0.0 )
+    return 0.0;
+  double side = orientation > 0.0 ? 1.0 : -1.0;
+
+  for ( int i = 0; i < n; ++i )
+    in[i] = subject[i];
+  int count = n;
+
+  for ( int j = 0; j < m && count > 0; ++j )
+  {
+    const ConvexPoint& a = clip[j];
+    const ConvexPoint& b = clip[(j+1)%m];
+
+    // skip repeated points in the clip polygon
+    if ( a.x == b.x && a.y == b.y )
+      continue;
+
+    int outCount = 0;
+    const ConvexPoint* prev = &in[count-1];
+    double prevSide = side*cross(a,b,*prev);
+    for ( int i = 0; i < count; ++i )
+    {
+      const ConvexPoint* cur = &in[i];
+      double curSide = side*cross(a,b,*cur);
+
+      // add the crossing point when the edge enters or leaves the half plane
+      if ( (curSide >= 0.0) != (prevSide >= 0.0) )
+      {
+        double t = prevSide / (prevSide - curSide);
+        out[outCount].x = prev->x + t*(cur->x - prev->x);
+        out[outCount].y = prev->y + t*(cur->y - prev->y);
+        ++outCount;
+      }
+      if ( curSide >= 0.0 )
+        out[outCount++] = *cur;
+
+      prev = cur;
+      prevSide = curSide;
+    }
+
+    swap(in,out);
+    count = outCount;
+  }
+
+  return count < 3 ? 0.0 : fabs(doubleArea(in,count))*0.5;
+}
+
+// overlap score of two convex polygons already in fixed buffers
+double convexScore(const ConvexPoint* pts1, int n, const ConvexPoint* pts2,
+  int m)
+{
+  double polyIntersect = convexIntersectArea(pts1,n,pts2,m);
+  if ( polyIntersect <= 0.0 )
+    return 0.0;
+
+  double polyUnion = fabs(doubleArea(pts1,n))*0.5 +
+    fabs(doubleArea(pts2,m))*0.5 - polyIntersect;
 
   return polyIntersect / polyUnion;
 }
 
+template <typename P>
+double convexScore(const vector<P>& polygon1, const vector<P>& polygon2)
+{
+  ConvexPoint pts1[MAX_CONVEX_POINTS], pts2[MAX_CONVEX_POINTS];
+  int n = loadConvex(polygon1,pts1),
+      m = loadConvex(polygon2,pts2);
+  return convexScore(pts1,n,pts2,m);
+}
+
+double computeConvexScore(const vector<Point>& polygon1,
+  const vector<Point>& polygon2)
+{
+  return convexScore(polygon1,polygon2);
+}
+
+double computeConvexScore(const clipper::Polygon& polygon1,
+  const clipper::Polygon& polygon2)
+{
+  return convexScore(polygon1,polygon2);
+}
+
+void PreparedPolygon::prepare(const vector<Point>& p)
+{
+  polygon = p;
+  convexPolygon = isConvex(polygon);
+  clipperReady = clipper32Ready = false;
+
+  // area of the same truncated coordinates the clipper sees
+  clipperPolygon.resize(polygon.size());
+  for ( size_t i = 0; i < polygon.size(); ++i )
+    cvt(polygon[i],clipperPolygon[i]);
+  polygonArea = fabs(clipper::Area(clipperPolygon,false));
+  fits32 = fitsClipper32(clipperPolygon);
+
+  bounds = polygon.empty() ? Rect() : boundingBox(&polygon[0],polygon.size());
+}
+
+double computeScore(PreparedPolygon& prepared, const vector<Point>& polygon,
+  ScoreContext& context)
+{
+  if ( prepared.polygon.size() < 3 || polygon.size() < 3 )
+    return 0.0;
+
+  // polygons whose bounding boxes don't overlap can't overlap either
+  Rect overlap;
+  intersectRect(overlap,prepared.bounds,boundingBox(&polygon[0],polygon.size()));
+  if ( overlap.width <= 0 || overlap.height <= 0 )
+    return 0.0;
+
+  // small convex pairs are cheaper to intersect directly
+  if ( prepared.convexPolygon && isConvex(polygon) )
+    return convexScore(prepared.polygon,polygon);
+
+  context.polygon2.resize(polygon.size());
+  for ( size_t i = 0; i < polygon.size(); ++i )
+    cvt(polygon[i],context.polygon2[i]);
+
+  // the prepared edges are built the first time each clipper needs them
+  double polyIntersect;
+  bool clipped;
+  if ( prepared.fits32 && fitsClipper32(context.polygon2) )
+  {
+    if ( !prepared.clipper32Ready )
+    {
+      prepared.clipperEdges32.Prepare(prepared.clipperPolygon);
+      prepared.clipper32Ready = true;
+    }
+    clipped = intersectionArea(context.clipper32,prepared.clipperEdges32,
+      context.polygon2,polyIntersect);
+  }
+  else
+  {
+    if ( !prepared.clipperReady )
+    {
+      prepared.clipperEdges.Prepare(prepared.clipperPolygon);
+      prepared.clipperReady = true;
+    }
+    clipped = intersectionArea(context.clipper,prepared.clipperEdges,
+      context.polygon2,polyIntersect);
+  }
+  if ( !clipped )
+    return 0;
+
+  double polyArea = fabs(clipper::Area(context.polygon2,false));
+  return polyIntersect / (prepared.polygonArea + polyArea - polyIntersect);
+}
+
+// ellipses
+//
+// Sampling an ellipse at equal steps t of its parameter gives the affine image
+// of a regular polygon inscribed in a circle, so every ellipse loses the same
+// fraction of its area, 1-sin(t)/t < t^2/6.  Scaling the points out until the
+// areas match leaves a symmetric difference of at most half that, and the
+// score of two shapes is then off by at most twice their symmetric difference
+// over the union (t^2/3 in all).  Points are not truncated, small ellipses
+// would lose too much of their shape.
+
+// outlines are scaled by this before clipping so the ellipse keeps its shape
+// once it is converted to integers
+const double ELLIPSE_CLIP_SCALE = 16.0;
+
+// number of points needed to keep the score within ELLIPSE_SCORE_ERROR
+int ellipsePoints()
+{
+  int n = (int)ceil(2.0*M_PI / sqrt(3.0*ELLIPSE_SCORE_ERROR));
+  return min(max(n,8),MAX_ELLIPSE_POINTS);
+}
+
+// fills a fixed buffer with the ellipse polygon, returns the number of points
+int loadEllipse(const Ellipse& ellipse, ConvexPoint* pts)
+{
+  int n = ellipsePoints();
+  double step = 2.0*M_PI / n;
+  double scale = sqrt(step / sin(step));
+  double c = cos(ellipse.angle * M_PI / 180.0),
+         s = sin(ellipse.angle * M_PI / 180.0);
+
+  // rotate clockwise (y axis points down) the same way as rotated boxes
+  for ( int i = 0; i < n; ++i )
+  {
+    double dx = scale * ellipse.a * cos(i*step),
+           dy = scale * ellipse.b * sin(i*step);
+    pts[i].x = ellipse.x + dx*c - dy*s;
+    pts[i].y = ellipse.y + dx*s + dy*c;
+  }
+  return n;
+}
+
+// exact overlap score of two circles
+double circleScore(const Ellipse& c1, const Ellipse& c2)
+{
+  double r1 = c1.a, r2 = c2.a;
+  double d = sqrt((double)(c1.x-c2.x)*(c1.x-c2.x) +
+                  (double)(c1.y-c2.y)*(c1.y-c2.y));
+  if ( r1 <= 0.0 || r2 <= 0.0 || d >= r1 + r2 )
+    return 0.0;
+
+  double area1 = M_PI*r1*r1,
+         area2 = M_PI*r2*r2,
+         intersect;
+  if ( d <= fabs(r1 - r2) )
+    intersect = min(area1,area2);  // one circle inside the other
+  else
+  {
+    // a circular segment on each side of the common chord, a1 and a2 are
+    // half the angles the chord makes at each center
+    double cos1 = (d*d + r1*r1 - r2*r2) / (2.0*d*r1),
+           cos2 = (d*d + r2*r2 - r1*r1) / (2.0*d*r2);
+    double a1 = acos(max(-1.0,min(1.0,cos1))),
+           a2 = acos(max(-1.0,min(1.0,cos2)));
+    intersect = r1*r1*(a1 - 0.5*sin(2.0*a1)) + r2*r2*(a2 - 0.5*sin(2.0*a2));
+  }
+  return intersect / (area1 + area2 - intersect);
+}
+
+Rect boundingBox(const Ellipse& ellipse)
+{
+  double c = cos(ellipse.angle * M_PI / 180.0),
+         s = sin(ellipse.angle * M_PI / 180.0);
+  double halfWidth = sqrt(ellipse.a*ellipse.a*c*c + ellipse.b*ellipse.b*s*s),
+         halfHeight = sqrt(ellipse.a*ellipse.a*s*s + ellipse.b*ellipse.b*c*c);
+  return Rect(ellipse.x - halfWidth, ellipse.y - halfHeight,
+              2.0*halfWidth, 2.0*halfHeight);
+}
+
+void ellipsePolygon(const Ellipse& ellipse, vector<Point>& polygon)
+{
+  ConvexPoint pts[MAX_ELLIPSE_POINTS];
+  int n = loadEllipse(ellipse,pts);
+  polygon.resize(n);
+  for ( int i = 0; i < n; ++i )
+    polygon[i] = Point(pts[i].x, pts[i].y);
+}
+
+double computeScore(const Ellipse& ellipse1, const Ellipse& ellipse2)
+{
+  if ( ellipse1.isCircle() && ellipse2.isCircle() )
+    return circleScore(ellipse1,ellipse2);
+
+  Rect overlap;
+  intersectRect(overlap,boundingBox(ellipse1),boundingBox(ellipse2));
+  if ( overlap.width <= 0 || overlap.height <= 0 )
+    return 0.0;
+
+  ConvexPoint pts1[MAX_ELLIPSE_POINTS], pts2[MAX_ELLIPSE_POINTS];
+  int n = loadEllipse(ellipse1,pts1),
+      m = loadEllipse(ellipse2,pts2);
+  return convexScore(pts1,n,pts2,m);
+}
+
+double computeScore(const Ellipse& ellipse, const vector<Point>& polygon,
+  ScoreContext& context)
+{
+  if ( polygon.size() < 3 )
+    return 0.0;
+
+  Rect overlap;
+  intersectRect(overlap,boundingBox(ellipse),
+    boundingBox(&polygon[0],polygon.size()));
+  if ( overlap.width <= 0 || overlap.height <= 0 )
+    return 0.0;
+
+  ConvexPoint pts1[MAX_ELLIPSE_POINTS];
+  int n = loadEllipse(ellipse,pts1);
+
+  if ( isConvex(polygon) )
+  {
+    ConvexPoint pts2[MAX_CONVEX_POINTS];
+    int m = loadConvex(polygon,pts2);
+    return convexScore(pts1,n,pts2,m);
+  }
+
+  // the polygon is truncated as usual before both are scaled up
+  context.polygon1.resize(n);
+  for ( int i = 0; i < n; ++i )
+  {
+    context.polygon1[i].X =
+      (clipper::long64)floor(pts1[i].x*ELLIPSE_CLIP_SCALE + 0.5);
+    context.polygon1[i].Y =
+      (clipper::long64)floor(pts1[i].y*ELLIPSE_CLIP_SCALE + 0.5);
+  }
+  context.polygon2.resize(polygon.size());
+  for ( size_t i = 0; i < polygon.size(); ++i )
+  {
+    cvt(polygon[i],context.polygon2[i]);
+    context.polygon2[i].X *= (clipper::long64)ELLIPSE_CLIP_SCALE;
+    context.polygon2[i].Y *= (clipper::long64)ELLIPSE_CLIP_SCALE;
+  }
+  return computeClipperScore(context.polygon1,context.polygon2,context);
+}
+
+// masks
+
+// walks the foreground runs of a mask, each run covers [start,end) of the
+// pixels in column-major order
+struct RunCursor
+{
+  RunCursor(const RLE& m) : mask(m), index(0), start(0), end(0) {}
+
+  // moves to the next non-empty foreground run, false after the last one
+  bool next()
+  {
+    while ( index + 1 < mask.size )
+    {
+      start = end + mask.counts[index];
+      end = start + mask.counts[index+1];
+      index += 2;
+      if ( end > start )
+        return true;
+    }
+    return false;
+  }
+
+  const RLE& mask;
+  size_t index, start, end;
+};
+
+double maskArea(const RLE& mask)
+{
+  double area = 0.0;
+  for ( size_t i = 1; i < mask.size; i += 2 )
+    area += mask.counts[i];
+  return area;
+}
+
+Rect boundingBox(const RLE& mask)
+{
+  RunCursor run(mask);
+  if ( mask.height <= 0 || !run.next() )
+    return Rect();
+
+  size_t h = mask.height;
+  size_t left = run.start / h, right = left, top = h, bottom = 0;
+  do
+  {
+    size_t x1 = run.start / h, x2 = (run.end - 1) / h;
+    left = min(left,x1);
+    right = max(right,x2);
+    if ( x1 != x2 )
+    {
+      // the run wraps into the next column so it covers every row
+      top = 0;
+      bottom = h - 1;
+    }
+    else
+    {
+      top = min(top,run.start % h);
+      bottom = max(bottom,(run.end - 1) % h);
+    }
+  } while ( run.next() );
+
+  return Rect(left, top, right - left + 1, bottom - top + 1);
+}
+
+double computeScore(const RLE& mask1, const RLE& mask2)
+{
+  if ( mask1.height != mask2.height || mask1.width != mask2.width )
+    return 0.0;
+
+  // merge the two lists of foreground runs, the areas are added up as each
+  // run is reached
+  RunCursor run1(mask1), run2(mask2);
+  double area1 = 0.0, area2 = 0.0, intersect = 0.0;
+  bool more1 = run1.next(), more2 = run2.next();
+  if ( more1 ) area1 += run1.end - run1.start;
+  if ( more2 ) area2 += run2.end - run2.start;
+  while ( more1 && more2 )
+  {
+    size_t lo = max(run1.start,run2.start), hi = min(run1.end,run2.end);
+    if ( hi > lo )
+      intersect += hi - lo;
+
+    if ( run1.end < run2.end )
+    {
+      if ( (more1 = run1.next()) )
+        area1 += run1.end - run1.start;
+    }
+    else if ( (more2 = run2.next()) )
+      area2 += run2.end - run2.start;
+  }
+  if ( intersect <= 0.0 )
+    return 0.0;
+  while ( run1.next() )
+    area1 += run1.end - run1.start;
+  while ( run2.next() )
+    area2 += run2.end - run2.start;
+
+  return intersect / (area1 + area2 - intersect);
+}
+
+void polygonRLE(const vector<Point>& polygon, int height, int width,
+  vector<unsigned int>& counts)
+{
+  counts.clear();
+  size_t pos = 0;
+
+  if ( polygon.size() >= 3 && height > 0 && width > 0 )
+  {
+    Rect box = boundingBox(&polygon[0],polygon.size());
+    int first = max(0,(int)ceil(box.x - 0.5f)),
+        last = min(width - 1,(int)floor(box.x + box.width - 0.5f));
+
+    // every column is scanned down its center, the rows between pairs of
+    // edge crossings are inside
+    vector<double> crossings;
+    for ( int x = first; x <= last; ++x )
+    {
+      double cx = x + 0.5;
+      crossings.clear();
+      for ( size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++ )
+      {
+        const Point& p = polygon[j];
+        const Point& q = polygon[i];
+        if ( (p.x <= cx) != (q.x <= cx) )
+          crossings.push_back(p.y + (cx - p.x) * (q.y - p.y) / (q.x - p.x));
+      }
+      sort(crossings.begin(),crossings.end());
+
+      for ( size_t i = 0; i + 1 < crossings.size(); i += 2 )
+      {
+        int top = max(0,(int)ceil(crossings[i] - 0.5)),
+            bottom = min(height,(int)ceil(crossings[i+1] - 0.5));
+        if ( bottom <= top )
+          continue;
+
+        size_t start = (size_t)x * height + top,
+               end = (size_t)x * height + bottom;
+        if ( start == pos && !counts.empty() )
+          counts.back() += end - start;  // continues the previous run
+        else
+        {
+          counts.push_back(start - pos);
+          counts.push_back(end - start);
+        }
+        pos = end;
+      }
+    }
+  }
+
+  counts.push_back((size_t)height * width - pos);
+}
+
+double computeScore(const RLE& mask, const vector<Point>& polygon,
+  ScoreContext& context)
+{
+  polygonRLE(polygon,mask.height,mask.width,context.counts);
+  return computeScore(mask,
+    RLE(mask.height,mask.width,&context.counts[0],context.counts.size()));
+}
+
+double computeScore(const RLE& mask, const Ellipse& ellipse,
+  ScoreContext& context)
+{
+  ellipsePolygon(ellipse,context.outline);
+  return computeScore(mask,context.outline,context);
+}
+
 int checkValid(const Rect& testRect,
   const vector<Rect>& validRects,double threshold)
 {
   double scr;
   int index = -1;
-  for ( vector<Rect>::const_iterator i = validRects.begin();
-        i < validRects.end(); ++i )
+  for ( size_t i = 0; i < validRects.size(); ++i )
   {
-    scr = computeScore(testRect,*i);
+    scr = computeScore(testRect,validRects[i]);
     if ( scr > threshold )
     {
       // set a new threshold
       threshold = scr;
 
       // set index to most overlapping thus far
-      index = distance(validRects.begin(),i);
+      index = i;
     }
   }
   return index;
@@ -106,21 +780,189 @@ int checkValid(const vector<Point>& testPoly,
 {
   double scr;
   int index = -1;
-  for ( vector<vector<Point> >::const_iterator i = validPolys.begin();
-        i < validPolys.end(); ++i )
+  for ( size_t i = 0; i < validPolys.size(); ++i )
   {
-    scr = computeScore(testPoly,*i);
+    scr = computeScore(testPoly,validPolys[i]);
     if ( scr > threshold )
     {
       // set a new threshold
       threshold = scr;
 
       // set index to best match thus far
-      index = distance(validPolys.begin(),i);
+      index = i;
     }
   }
   return index;
 }
 
+// best overlapping candidate as checkValid() would return it.  With a
+// negative threshold checkValid() accepts every candidate, so when none
+// overlaps the query it returns the first one with a score of 0.
+inline BestMatch acceptBest(const BestMatch& best, size_t candidates,
+  double threshold)
+{
+  if ( best.index >= 0 && best.score > 0.0 && best.score > threshold )
+    return best;
+  if ( threshold < 0.0 && candidates > 0 )
+    return BestMatch(0,0.0);
+  return BestMatch();
+}
+
+void checkValid(const vector<Rect>& testRects,
+  const vector<Rect>& validRects, vector<BestMatch>& best, double threshold)
+{
+  RectIndex index(validRects);
+  vector<double> scores;
+
+  best.resize(testRects.size());
+  for ( size_t i = 0; i < testRects.size(); ++i )
+  {
+    best[i] = acceptBest(index.best(testRects[i],scores),validRects.size(),
+                         threshold);
+  }
+}
+
+void checkValid(const vector<vector<Point> >& testPolys,
+  const vector<vector<Point> >& validPolys, vector<BestMatch>& best,
+  double threshold)
+{
+  // the candidates are indexed by bounding box and prepared once
+  vector<Rect> boxes(validPolys.size());
+  vector<PreparedPolygon> prepared(validPolys.size());
+  for ( size_t i = 0; i < validPolys.size(); ++i )
+  {
+    prepared[i].prepare(validPolys[i]);
+    boxes[i] = prepared[i].box();
+  }
+  RectIndex index(boxes);
+
+  ScoreContext& context = threadContext();
+  vector<int> candidates;
+  best.resize(testPolys.size());
+  for ( size_t i = 0; i < testPolys.size(); ++i )
+  {
+    best[i] = BestMatch();
+    if ( !testPolys[i].empty() )
+    {
+      // candidates come back in ascending order so the first of several
+      // equal scores is kept, like checkValid()
+      candidates.clear();
+      index.query(boundingBox(&testPolys[i][0],testPolys[i].size()),
+                  candidates);
+      for ( size_t j = 0; j < candidates.size(); ++j )
+      {
+        double scr = computeScore(prepared[candidates[j]],testPolys[i],
+                                  context);
+        if ( scr > best[i].score || best[i].index < 0 )
+          best[i] = BestMatch(candidates[j],scr);
+      }
+    }
+    best[i] = acceptBest(best[i],validPolys.size(),threshold);
+  }
+}
+
+// used to sort rectangle indices by their left edge
+struct LeftEdgeLess
+{
+  LeftEdgeLess(const vector<Rect>& r) : rects(r) {}
+  bool operator()(int lhs, int rhs) const { return rects[lhs].x < rects[rhs].x; }
+  const vector<Rect>& rects;
+};
+
+void RectIndex::build(const vector<Rect>& r)
+{
+  rects = r;
+  maxWidth = 0;
+
+  order.resize(rects.size());
+  for ( size_t i = 0; i < rects.size(); ++i )
+  {
+    order[i] = i;
+    maxWidth = max(maxWidth, rects[i].width);
+  }
+  sort(order.begin(), order.end(), LeftEdgeLess(rects));
+
+  // the edges are also kept in left edge order so best() can score a range
+  // of them in one pass
+  lefts.resize(rects.size());
+  tops.resize(rects.size());
+  rights.resize(rects.size());
+  bottoms.resize(rects.size());
+  areas.resize(rects.size());
+  for ( size_t i = 0; i < order.size(); ++i )
+  {
+    const Rect& r = rects[order[i]];
+    lefts[i] = r.x;
+    tops[i] = r.y;
+    rights[i] = r.x + r.width;
+    bottoms[i] = r.y + r.height;
+    areas[i] = r.width * r.height;
+  }
 }
 
+void RectIndex::query(const Rect& query, vector<int>& overlapping) const
+{
+  size_t first = overlapping.size();
+
+  // only rectangles starting in [left-maxWidth, right) can reach the query
+  vector<float>::const_iterator begin =
+    lower_bound(lefts.begin(), lefts.end(), query.x - maxWidth);
+  vector<float>::const_iterator end =
+    lower_bound(begin, lefts.end(), query.x + query.width);
+
+  for ( vector<float>::const_iterator i = begin; i != end; ++i )
+  {
+    int index = order[i - lefts.begin()];
+    const Rect& r = rects[index];
+    if ( r.x + r.width > query.x &&
+         r.y < query.y + query.height && r.y + r.height > query.y )
+      overlapping.push_back(index);
+  }
+
+  sort(overlapping.begin() + first, overlapping.end());
+}
+
+BestMatch RectIndex::best(const Rect& query, vector<double>& scores) const
+{
+  size_t begin = lower_bound(lefts.begin(), lefts.end(), query.x - maxWidth) -
+                 lefts.begin();
+  size_t end = lower_bound(lefts.begin() + begin, lefts.end(),
+                           query.x + query.width) - lefts.begin();
+  size_t count = end - begin;
+  if ( count == 0 )
+    return BestMatch();
+  scores.resize(count);
+
+  // same arithmetic as computeScore(const Rect&,const Rect&) without
+  // branches so the compiler can vectorize it, rectangles that miss the
+  // query score zero
+  const float qLeft = query.x, qTop = query.y,
+              qRight = query.x + query.width,
+              qBottom = query.y + query.height,
+              qArea = query.width * query.height;
+  const float* l = &lefts[0] + begin;
+  const float* t = &tops[0] + begin;
+  const float* r = &rights[0] + begin;
+  const float* b = &bottoms[0] + begin;
+  const float* a = &areas[0] + begin;
+  double* out = &scores[0];
+  for ( size_t i = 0; i < count; ++i )
+  {
+    float width = max(min(qRight,r[i]) - max(qLeft,l[i]), 0.0f),
+          height = max(min(qBottom,b[i]) - max(qTop,t[i]), 0.0f);
+    double intersect = width * height;
+    out[i] = intersect / ((qArea + a[i]) - intersect);
+  }
+
+  BestMatch match;
+  for ( size_t i = 0; i < count; ++i )
+  {
+    int index = order[begin + i];
+    if ( out[i] > match.score ||
+         ( out[i] == match.score && match.index >= 0 && index < match.index ) )
+      match = BestMatch(index, out[i]);
+  }
+  return match;
+}
+
+}
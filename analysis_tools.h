@@ -4,6 +4,28 @@
 //
 // computeScore() computes overlap score using Intersection/Union
 //
+// Polygon scoring needs a clipper instance and some buffers, these live in a
+// ScoreContext.  The overloads without a context use one context per thread
+// so every function here can be called from several threads at once.
+//
+// When both polygons are convex (e.g. rotated boxes) computeScore() skips the
+// clipper and intersects them directly with computeConvexScore().  The
+// clipper rounds the intersection points to integer coordinates while the
+// convex kernel keeps them exact, so scores of convex pairs (every rbox
+// region) can differ from the clipper's by a few hundredths on small regions
+// (up to 0.037 in polygon_bench).  Pairs scored right at overlap_threshold can
+// therefore switch between match and no match compared to the clipper.
+//
+// Circles are scored exactly.  Ellipses are replaced by polygons with the
+// same area and enough points to keep the score within ELLIPSE_SCORE_ERROR.
+//
+// Masks are stored as column-major run lengths (the COCO layout) and are
+// scored on the runs without decoding them to a bitmap.
+//
+// A polygon that is scored against many others (e.g. a ground truth region)
+// can be wrapped in a PreparedPolygon so its area, bounding box, convexity and
+// clipper edges are only worked out once.
+//
 // Author : Joshua Gleason
 // Date   : June 2, 2011
 //
@@ -32,6 +54,77 @@ namespace analysis_tools
     float x, y, width, height;
   };
 
+  // ellipse with semi-axes a (along x) and b (along y) rotated clockwise by
+  // angle degrees about its center, a circle has a == b
+  struct Ellipse
+  {
+    Ellipse() : x(0), y(0), a(0), b(0), angle(0) {}
+    Ellipse(float _x, float _y, float _a, float _b, float _angle) :
+      x(_x), y(_y), a(_a), b(_b), angle(_angle) {}
+    bool isCircle() const { return a == b; }
+    float x, y, a, b, angle;
+  };
+
+  // column-major run-length encoded mask (the COCO layout). The counts
+  // alternate between background and foreground runs, starting with
+  // background, and add up to height*width.  The counts are not copied.
+  struct RLE
+  {
+    RLE() : height(0), width(0), counts(0), size(0) {}
+    RLE(int _h, int _w, const unsigned int* _c, size_t _n) :
+      height(_h), width(_w), counts(_c), size(_n) {}
+    int height, width;
+    const unsigned int* counts;
+    size_t size;
+  };
+
+  // scratch space for polygon scoring, the clippers and buffers are reused by
+  // every call. A context must only be used by one thread at a time.
+  // clipper32 is used whenever the coordinates fit in 32 bits.
+  struct ScoreContext
+  {
+    clipper::Clipper clipper;
+    clipper::Clipper32 clipper32;
+    clipper::Polygon polygon1, polygon2;
+    vector<Point> outline;        // shapes converted for mask scoring
+    vector<unsigned int> counts;
+  };
+
+  // a polygon prepared for repeated scoring, the clipper edges are only built
+  // the first time they are needed.  Scoring changes the cached edges so a
+  // prepared polygon must only be used by one thread at a time.
+  class PreparedPolygon
+  {
+    public:
+      PreparedPolygon() : convexPolygon(false), polygonArea(0.0),
+        fits32(true), clipperReady(false), clipper32Ready(false) {}
+      explicit PreparedPolygon(const vector<Point>& p) : convexPolygon(false),
+        polygonArea(0.0), fits32(true), clipperReady(false),
+        clipper32Ready(false) { prepare(p); }
+
+      // (re)prepare for a new polygon
+      void prepare(const vector<Point>&);
+
+      const vector<Point>& points() const { return polygon; }
+      bool convex() const { return convexPolygon; }
+      double area() const { return polygonArea; }
+      const Rect& box() const { return bounds; }
+
+    private:
+      friend double computeScore(PreparedPolygon&, const vector<Point>&,
+        ScoreContext&);
+
+      vector<Point> polygon;
+      bool convexPolygon;
+      double polygonArea;
+      Rect bounds;
+      clipper::Polygon clipperPolygon;
+      bool fits32;  // coordinates fit the 32 bit clipper
+      clipper::PreparedPolygon clipperEdges;
+      clipper::PreparedPolygon32 clipperEdges32;
+      bool clipperReady, clipper32Ready;
+  };
+
   // calculate the intersection rectangle
   void intersectRect(Rect& intersect, const Rect& r1, const Rect& r2);
 
@@ -46,8 +139,111 @@ namespace analysis_tools
   double computeScore(const Rect&, const Rect&);
   double computeScore(const clipper::Polygon&, const clipper::Polygon&);
 
+  // same as above but using the caller's scratch space
+  double computeScore(const vector<Point>&, const vector<Point>&, ScoreContext&);
+  double computeScore(const clipper::Polygon&, const clipper::Polygon&,
+    ScoreContext&);
+
+  // overlap score of a prepared polygon and another polygon
+  double computeScore(PreparedPolygon&, const vector<Point>&, ScoreContext&);
+
+  // largest polygon handled by the convex kernel, bigger ones use the clipper
+  const int MAX_CONVEX_POINTS = 32;
+
+  // true if the polygon is convex (either orientation) and small enough for
+  // computeConvexScore()
+  bool isConvex(const vector<Point>&);
+  bool isConvex(const clipper::Polygon&);
+
+  // overlap score of two polygons that pass isConvex(), computed with
+  // Sutherland-Hodgman clipping in fixed size buffers (no allocation)
+  double computeConvexScore(const vector<Point>&, const vector<Point>&);
+  double computeConvexScore(const clipper::Polygon&, const clipper::Polygon&);
+
+  // overlap score computed with the general clipper whatever the input shape
+  double computeClipperScore(const clipper::Polygon&, const clipper::Polygon&,
+    ScoreContext&);
+
+  // largest error in the score of an ellipse that is not a circle
+  const double ELLIPSE_SCORE_ERROR = 0.005;
+
+  // overlap score of two ellipses, exact when both are circles
+  double computeScore(const Ellipse&, const Ellipse&);
+
+  // overlap score of an ellipse and a polygon, convex polygons are
+  // intersected directly and others with the clipper
+  double computeScore(const Ellipse&, const vector<Point>&, ScoreContext&);
+
+  // polygon with the same area as the ellipse used for scoring, the number
+  // of points follows from ELLIPSE_SCORE_ERROR
+  void ellipsePolygon(const Ellipse&, vector<Point>&);
+
+  // number of pixels set in a mask
+  double maskArea(const RLE&);
+
+  // overlap score of two masks of the same size computed on the runs
+  double computeScore(const RLE&, const RLE&);
+
+  // overlap score of a mask and another shape, the shape is run-length
+  // encoded first the same way as polygonRLE()
+  double computeScore(const RLE&, const vector<Point>&, ScoreContext&);
+  double computeScore(const RLE&, const Ellipse&, ScoreContext&);
+
+  // encodes the pixels of a height x width mask whose centers are inside the
+  // polygon (even-odd rule)
+  void polygonRLE(const vector<Point>&, int, int, vector<unsigned int>&);
+
   // compute the bounding box for a polygon
   Rect boundingBox(const Point*,int);
+  Rect boundingBox(const Ellipse&);
+  Rect boundingBox(const RLE&);
+
+  // best scoring candidate for one query, index is -1 if no candidate
+  // scored above the threshold
+  struct BestMatch
+  {
+    BestMatch() : index(-1), score(0.0) {}
+    BestMatch(int i, double s) : index(i), score(s) {}
+    int index;
+    double score;
+  };
+
+  // index over a fixed list of rectangles used to find every rectangle that
+  // overlaps a query rectangle without testing the whole list
+  class RectIndex
+  {
+    public:
+      RectIndex() : maxWidth(0) {}
+      explicit RectIndex(const vector<Rect>& r) : maxWidth(0) { build(r); }
+
+      // (re)build the index over a list of rectangles
+      void build(const vector<Rect>&);
+
+      // append the indices (in ascending order) of every rectangle whose
+      // intersection with the query has a non-zero area
+      void query(const Rect&, vector<int>&) const;
+
+      // highest scoring rectangle for the query (lowest index on ties),
+      // scores are computed branch free over the range of left edges that
+      // can reach the query.  The vector is scratch space.
+      BestMatch best(const Rect&, vector<double>&) const;
+
+    private:
+      vector<Rect> rects;
+      vector<int> order;    // rectangle indices sorted by left edge
+      vector<float> lefts;  // left edges in the same order
+      vector<float> tops, rights, bottoms, areas;
+      float maxWidth;
+  };
+
+  // batched checkValid(), every query is compared against the same list of
+  // candidates which is only indexed once.  best[i] holds the best candidate
+  // for queries[i] the same way checkValid() picks it, including the first
+  // candidate at score 0 when the threshold is negative and none overlaps
+  void checkValid(const vector<Rect>&, const vector<Rect>&,
+    vector<BestMatch>&, double=0.0);
+  void checkValid(const vector<vector<Point> >&, const vector<vector<Point> >&,
+    vector<BestMatch>&, double=0.0);
 }
 
 #endif // ANALYSIS_TOOLS
@@ -0,0 +1,259 @@
+//
+// Description : Benchmark for the polygon overlap scores.  Random pairs of
+//               overlapping rotated boxes are scored with the general clipper
+//               and with the convex kernel, the time per pair and the largest
+//               difference between the two scores are printed.
+//
+//               The clipper rounds intersection points to integers while the
+//               convex kernel does not, so the kernel is checked against the
+//               clipper run on coordinates scaled up by CHECK_SCALE.
+//
+//               A second pass times the intersection of pairs of polygons
+//               of growing complexity with the current clipper and with the
+//               baseline copy in clipper_baseline.h (linked list scanbeams
+//               and intersections): simple star shaped polygons, and random
+//               self-intersecting ones with many crossings per scanbeam.
+//
+// Usage : polygon_bench [pairs] [repeats] [max_points]
+//
+
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include "../analysis_tools.h"
+#include "clipper_baseline.h"
+
+namespace at = analysis_tools;
+namespace pt = boost::posix_time;
+
+const double CHECK_SCALE = 10000.0;
+
+// corners of a box rotated about its center (same rounding as the rbox
+// region format)
+std::vector<at::Point> RotatedBox(double cx, double cy, double w, double h,
+  double angle)
+{
+  double c = std::cos(angle), s = std::sin(angle);
+  double dx[4] = { -w/2, w/2, w/2, -w/2 };
+  double dy[4] = { -h/2, -h/2, h/2, h/2 };
+
+  std::vector<at::Point> box(4);
+  for ( int i = 0; i < 4; ++i )
+    box[i] = at::Point(
+      std::floor(cx + dx[i]*c - dy[i]*s + 0.5),
+      std::floor(cy + dx[i]*s + dy[i]*c + 0.5));
+  return box;
+}
+
+double Random(double low, double high)
+{
+  return low + (high-low)*(std::rand() / (RAND_MAX + 1.0));
+}
+
+// converts a polygon to (scaled) clipper coordinates
+clipper::Polygon ToClipper(const std::vector<at::Point>& polygon,
+  double scale = 1.0)
+{
+  clipper::Polygon out(polygon.size());
+  for ( size_t i = 0; i < polygon.size(); ++i )
+  {
+    out[i].X = (clipper::long64)(polygon[i].x*scale);
+    out[i].Y = (clipper::long64)(polygon[i].y*scale);
+  }
+  return out;
+}
+
+// simple polygon with points at random distances around a center
+clipper::Polygon StarPolygon(int points, double cx, double cy, double radius)
+{
+  clipper::Polygon star(points);
+  for ( int i = 0; i < points; ++i )
+  {
+    double angle = 2*3.14159265358979*i/points;
+    double r = radius*Random(0.5, 1.0);
+    star[i].X = (clipper::long64)(cx + r*std::cos(angle));
+    star[i].Y = (clipper::long64)(cy + r*std::sin(angle));
+  }
+  return star;
+}
+
+// self-intersecting polygon with points anywhere in a square
+clipper::Polygon RandomPolygon(int points, double size)
+{
+  clipper::Polygon random(points);
+  for ( int i = 0; i < points; ++i )
+  {
+    random[i].X = (clipper::long64)Random(0, size);
+    random[i].Y = (clipper::long64)Random(0, size);
+  }
+  return random;
+}
+
+// same polygon for the baseline clipper
+clipper_baseline::Polygon ToBaseline(const clipper::Polygon& polygon)
+{
+  clipper_baseline::Polygon out(polygon.size());
+  for ( size_t i = 0; i < polygon.size(); ++i )
+  {
+    out[i].X = polygon[i].X;
+    out[i].Y = polygon[i].Y;
+  }
+  return out;
+}
+
+void Intersect(clipper::Clipper& c, const clipper::Polygon& first,
+  const clipper::Polygon& second, clipper::Polygons& solution)
+{
+  c.Clear();
+  c.AddPolygon(first, clipper::ptSubject);
+  c.AddPolygon(second, clipper::ptClip);
+  c.Execute(clipper::ctIntersection, solution);
+}
+
+void Intersect(clipper_baseline::Clipper& c,
+  const clipper_baseline::Polygon& first,
+  const clipper_baseline::Polygon& second,
+  clipper_baseline::Polygons& solution)
+{
+  c.Clear();
+  c.AddPolygon(first, clipper_baseline::ptSubject);
+  c.AddPolygon(second, clipper_baseline::ptClip);
+  c.Execute(clipper_baseline::ctIntersection, solution);
+}
+
+// average time in microseconds to intersect each pair
+template <class ClipperType, class Polygons>
+double TimeIntersect(const Polygons& first, const Polygons& second)
+{
+  ClipperType c;
+  Polygons solution;
+  int repeats = 0;
+  pt::ptime start = pt::microsec_clock::universal_time();
+  pt::time_duration elapsed;
+  do
+  {
+    for ( size_t i = 0; i < first.size(); ++i )
+      Intersect(c, first[i], second[i], solution);
+    ++repeats;
+    elapsed = pt::microsec_clock::universal_time() - start;
+  } while ( elapsed.total_milliseconds() < 200 );
+
+  return double(elapsed.total_microseconds()) / (repeats*first.size());
+}
+
+// times both clippers for polygons with 8 to max_points points
+void ComplexitySweep(int max_points)
+{
+  std::cout << std::endl << std::setw(8) << "points"
+            << std::setw(14) << "star old"
+            << std::setw(14) << "star new"
+            << std::setw(14) << "random old"
+            << std::setw(14) << "random new"
+            << "   (us per pair)" << std::endl;
+
+  for ( int points = 8; points <= max_points; points *= 2 )
+  {
+    const int samples = 8;
+    clipper::Polygons star1, star2, random1, random2;
+    clipper_baseline::Polygons old_star1, old_star2, old_random1, old_random2;
+    for ( int i = 0; i < samples; ++i )
+    {
+      star1.push_back(StarPolygon(points, 5000, 5000, 4000));
+      star2.push_back(StarPolygon(points, 6000, 5500, 4000));
+      random1.push_back(RandomPolygon(points, 10000));
+      random2.push_back(RandomPolygon(points, 10000));
+      old_star1.push_back(ToBaseline(star1.back()));
+      old_star2.push_back(ToBaseline(star2.back()));
+      old_random1.push_back(ToBaseline(random1.back()));
+      old_random2.push_back(ToBaseline(random2.back()));
+    }
+
+    std::cout << std::fixed << std::setprecision(1) << std::setw(8) << points
+              << std::setw(14)
+              << TimeIntersect<clipper_baseline::Clipper>(old_star1, old_star2)
+              << std::setw(14)
+              << TimeIntersect<clipper::Clipper>(star1, star2)
+              << std::setw(14)
+              << TimeIntersect<clipper_baseline::Clipper>(old_random1,
+                                                          old_random2)
+              << std::setw(14)
+              << TimeIntersect<clipper::Clipper>(random1, random2)
+              << std::endl;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  int pairs = argc > 1 ? std::atoi(argv[1]) : 10000;
+  int repeats = argc > 2 ? std::atoi(argv[2]) : 10;
+  int max_points = argc > 3 ? std::atoi(argv[3]) : 1024;
+
+  // pairs of boxes that mostly overlap, the way detections and ground truth do
+  std::srand(12345);
+  std::vector< std::vector<at::Point> > first, second;
+  std::vector<clipper::Polygon> first_clipper, second_clipper;
+  for ( int i = 0; i < pairs; ++i )
+  {
+    double cx = Random(100, 1000), cy = Random(100, 1000);
+    double w = Random(20, 200), h = Random(20, 200);
+    first.push_back(RotatedBox(cx, cy, w, h, Random(0, 3.14159)));
+    second.push_back(RotatedBox(cx + Random(-w/2, w/2), cy + Random(-h/2, h/2),
+      w*Random(0.7, 1.3), h*Random(0.7, 1.3), Random(0, 3.14159)));
+    first_clipper.push_back(ToClipper(first.back()));
+    second_clipper.push_back(ToClipper(second.back()));
+  }
+
+  at::ScoreContext context;
+  double clipper_sum = 0.0, convex_sum = 0.0;
+  double max_difference = 0.0, max_rounding = 0.0;
+
+  // general clipper
+  pt::ptime start = pt::microsec_clock::universal_time();
+  for ( int r = 0; r < repeats; ++r )
+    for ( int i = 0; i < pairs; ++i )
+      clipper_sum += at::computeClipperScore(first_clipper[i],
+                                             second_clipper[i], context);
+  double clipper_time =
+    (pt::microsec_clock::universal_time() - start).total_microseconds();
+
+  // convex kernel
+  start = pt::microsec_clock::universal_time();
+  for ( int r = 0; r < repeats; ++r )
+    for ( int i = 0; i < pairs; ++i )
+      convex_sum += at::computeConvexScore(first[i], second[i]);
+  double convex_time =
+    (pt::microsec_clock::universal_time() - start).total_microseconds();
+
+  // both must agree on every pair
+  for ( int i = 0; i < pairs; ++i )
+  {
+    double convex = at::computeConvexScore(first[i], second[i]);
+    double exact = at::computeClipperScore(ToClipper(first[i], CHECK_SCALE),
+      ToClipper(second[i], CHECK_SCALE), context);
+    double rounded = at::computeClipperScore(first_clipper[i],
+      second_clipper[i], context);
+
+    max_difference = std::max(max_difference, std::fabs(convex - exact));
+    max_rounding = std::max(max_rounding, std::fabs(rounded - exact));
+  }
+
+  double calls = double(pairs) * repeats;
+  std::cout << std::fixed << std::setprecision(1)
+            << "pairs: " << pairs << " x " << repeats << std::endl
+            << "clipper: " << clipper_time*1000.0/calls << " ns/pair" << std::endl
+            << "convex : " << convex_time*1000.0/calls << " ns/pair" << std::endl
+            << std::setprecision(2)
+            << "speedup: " << clipper_time/convex_time << "x" << std::endl
+            << std::scientific
+            << "max score difference: " << max_difference << std::endl
+            << "clipper rounding error: " << max_rounding << std::endl
+            << "checksum: " << clipper_sum << " " << convex_sum << std::endl;
+
+  ComplexitySweep(max_points);
+
+  return max_difference < 1e-4 ? 0 : 1;
+}
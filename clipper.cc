@@ -36,6 +36,7 @@
 #include <stdexcept>
 #include <cstring>
 #include <cstdlib>
+#include <algorithm>
 
 //Workaround for older compilers that don't have std::abs
 #if (__GNUC__ == 2 && __GNUC_MINOR__ <= 97) || (defined(BOOST_MSVC) && _MSC_VER <= 1200)
@@ -275,6 +276,34 @@ private:
     }
 };
 
+//------------------------------------------------------------------------------
+// Coordinate types ...
+//------------------------------------------------------------------------------
+
+//Products of coordinate differences are calculated in 64bits, so only long64
+//coordinates ever need Int128 math. For 32bit coordinates the tests of
+//UseFullInt64Range below are constant and the 128bit code is compiled away.
+//loRange is the largest coordinate accepted without full range math ...
+template <typename cInt> struct CoordTraits;
+
+template <> struct CoordTraits< long64 >
+{
+  static const bool wide = true;
+  static const long64 loRange = 1500000000; //~ Sqrt(2^63)/2
+};
+
+template <> struct CoordTraits< int >
+{
+  static const bool wide = false;
+  static const long64 loRange = Clipper32Range;
+};
+
+template <typename cInt>
+inline bool UseInt128(bool UseFullInt64Range)
+{
+  return CoordTraits< cInt >::wide && UseFullInt64Range;
+}
+
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 
@@ -305,10 +334,11 @@ bool IsClockwise(const Polygon &poly, bool UseFullInt64Range)
 }
 //------------------------------------------------------------------------------
 
-bool IsClockwise(PolyPt *pt, bool UseFullInt64Range)
+template <typename cInt>
+bool IsClockwise(PolyPt< cInt > *pt, bool UseFullInt64Range)
 {
-  PolyPt* startPt = pt;
-  if (UseFullInt64Range)
+  PolyPt< cInt >* startPt = pt;
+  if (UseInt128< cInt >(UseFullInt64Range))
   {
     Int128 area(0);
     do
@@ -335,7 +365,9 @@ bool IsClockwise(PolyPt *pt, bool UseFullInt64Range)
 }
 //------------------------------------------------------------------------------
 
-inline bool PointsEqual( const IntPoint &pt1, const IntPoint &pt2)
+template <typename cInt>
+inline bool PointsEqual( const TIntPoint< cInt > &pt1,
+  const TIntPoint< cInt > &pt2)
 {
   return ( pt1.X == pt2.X && pt1.Y == pt2.Y );
 }
@@ -367,9 +399,10 @@ double Area(const Polygon &poly, bool UseFullInt64Range)
 }
 //------------------------------------------------------------------------------
 
-bool PointIsVertex(const IntPoint &pt, PolyPt *pp)
+template <typename cInt>
+bool PointIsVertex(const TIntPoint< cInt > &pt, PolyPt< cInt > *pp)
 {
-  PolyPt *pp2 = pp;
+  PolyPt< cInt > *pp2 = pp;
   do
   {
     if (PointsEqual(pp2->pt, pt)) return true;
@@ -380,11 +413,13 @@ bool PointIsVertex(const IntPoint &pt, PolyPt *pp)
 }
 //------------------------------------------------------------------------------
 
-bool PointInPolygon(const IntPoint &pt, PolyPt *pp, bool UseFullInt64Range)
+template <typename cInt>
+bool PointInPolygon(const TIntPoint< cInt > &pt, PolyPt< cInt > *pp,
+  bool UseFullInt64Range)
 {
-  PolyPt *pp2 = pp;
+  PolyPt< cInt > *pp2 = pp;
   bool result = false;
-  if (UseFullInt64Range) {
+  if (UseInt128< cInt >(UseFullInt64Range)) {
     do
     {
       if ((((pp2->pt.Y <= pt.Y) && (pt.Y < pp2->prev->pt.Y)) ||
@@ -402,7 +437,8 @@ bool PointInPolygon(const IntPoint &pt, PolyPt *pp, bool UseFullInt64Range)
     {
       if ((((pp2->pt.Y <= pt.Y) && (pt.Y < pp2->prev->pt.Y)) ||
         ((pp2->prev->pt.Y <= pt.Y) && (pt.Y < pp2->pt.Y))) &&
-        (pt.X - pp2->pt.X < (pp2->prev->pt.X - pp2->pt.X) * (pt.Y - pp2->pt.Y) /
+        (pt.X - pp2->pt.X <
+        (long64)(pp2->prev->pt.X - pp2->pt.X) * (pt.Y - pp2->pt.Y) /
         (pp2->prev->pt.Y - pp2->pt.Y))) result = !result;
       pp2 = pp2->next;
     }
@@ -412,43 +448,50 @@ bool PointInPolygon(const IntPoint &pt, PolyPt *pp, bool UseFullInt64Range)
 }
 //------------------------------------------------------------------------------
 
-bool SlopesEqual(TEdge &e1, TEdge &e2, bool UseFullInt64Range)
+template <typename cInt>
+bool SlopesEqual(TEdge< cInt > &e1, TEdge< cInt > &e2, bool UseFullInt64Range)
 {
   if (e1.ybot == e1.ytop) return (e2.ybot == e2.ytop);
   else if (e1.xbot == e1.xtop) return (e2.xbot == e2.xtop);
-  else if (UseFullInt64Range)
+  else if (UseInt128< cInt >(UseFullInt64Range))
     return Int128(e1.ytop - e1.ybot) * Int128(e2.xtop - e2.xbot) ==
       Int128(e1.xtop - e1.xbot) * Int128(e2.ytop - e2.ybot);
-  else return (e1.ytop - e1.ybot)*(e2.xtop - e2.xbot) ==
-      (e1.xtop - e1.xbot)*(e2.ytop - e2.ybot);
+  else return (long64)(e1.ytop - e1.ybot)*(e2.xtop - e2.xbot) ==
+      (long64)(e1.xtop - e1.xbot)*(e2.ytop - e2.ybot);
 }
 //------------------------------------------------------------------------------
 
-bool SlopesEqual(const IntPoint pt1, const IntPoint pt2,
-  const IntPoint pt3, bool UseFullInt64Range)
+template <typename cInt>
+bool SlopesEqual(const TIntPoint< cInt > pt1, const TIntPoint< cInt > pt2,
+  const TIntPoint< cInt > pt3, bool UseFullInt64Range)
 {
   if (pt1.Y == pt2.Y) return (pt2.Y == pt3.Y);
   else if (pt1.X == pt2.X) return (pt2.X == pt3.X);
-  else if (UseFullInt64Range)
+  else if (UseInt128< cInt >(UseFullInt64Range))
     return Int128(pt1.Y-pt2.Y) * Int128(pt2.X-pt3.X) ==
       Int128(pt1.X-pt2.X) * Int128(pt2.Y-pt3.Y);
-  else return (pt1.Y-pt2.Y)*(pt2.X-pt3.X) == (pt1.X-pt2.X)*(pt2.Y-pt3.Y);
+  else return
+    (long64)(pt1.Y-pt2.Y)*(pt2.X-pt3.X) == (long64)(pt1.X-pt2.X)*(pt2.Y-pt3.Y);
 }
 //------------------------------------------------------------------------------
 
-bool SlopesEqual(const IntPoint pt1, const IntPoint pt2,
-  const IntPoint pt3, const IntPoint pt4, bool UseFullInt64Range)
+template <typename cInt>
+bool SlopesEqual(const TIntPoint< cInt > pt1, const TIntPoint< cInt > pt2,
+  const TIntPoint< cInt > pt3, const TIntPoint< cInt > pt4,
+  bool UseFullInt64Range)
 {
   if (pt1.Y == pt2.Y) return (pt3.Y == pt4.Y);
   else if (pt1.X == pt2.X) return (pt3.X == pt4.X);
-  else if (UseFullInt64Range)
+  else if (UseInt128< cInt >(UseFullInt64Range))
     return Int128(pt1.Y-pt2.Y) * Int128(pt3.X-pt4.X) ==
       Int128(pt1.X-pt2.X) * Int128(pt3.Y-pt4.Y);
-  else return (pt1.Y-pt2.Y)*(pt3.X-pt4.X) == (pt1.X-pt2.X)*(pt3.Y-pt4.Y);
+  else return
+    (long64)(pt1.Y-pt2.Y)*(pt3.X-pt4.X) == (long64)(pt1.X-pt2.X)*(pt3.Y-pt4.Y);
 }
 //------------------------------------------------------------------------------
 
-void SetDx(TEdge &e)
+template <typename cInt>
+void SetDx(TEdge< cInt > &e)
 {
   if (e.ybot == e.ytop) e.dx = horizontal;
   else e.dx =
@@ -456,7 +499,8 @@ void SetDx(TEdge &e)
 }
 //---------------------------------------------------------------------------
 
-double GetDx(const IntPoint pt1, const IntPoint pt2)
+template <typename cInt>
+double GetDx(const TIntPoint< cInt > pt1, const TIntPoint< cInt > pt2)
 {
   if (pt1.Y == pt2.Y) return horizontal;
   else return
@@ -464,7 +508,8 @@ double GetDx(const IntPoint pt1, const IntPoint pt2)
 }
 //---------------------------------------------------------------------------
 
-void SwapSides(TEdge &edge1, TEdge &edge2)
+template <typename cInt>
+void SwapSides(TEdge< cInt > &edge1, TEdge< cInt > &edge2)
 {
   EdgeSide side =  edge1.side;
   edge1.side = edge2.side;
@@ -472,7 +517,8 @@ void SwapSides(TEdge &edge1, TEdge &edge2)
 }
 //------------------------------------------------------------------------------
 
-void SwapPolyIndexes(TEdge &edge1, TEdge &edge2)
+template <typename cInt>
+void SwapPolyIndexes(TEdge< cInt > &edge1, TEdge< cInt > &edge2)
 {
   int outIdx =  edge1.outIdx;
   edge1.outIdx = edge2.outIdx;
@@ -493,14 +539,17 @@ inline long64 Abs(long64 val)
 }
 //------------------------------------------------------------------------------
 
-long64 TopX(TEdge &edge, const long64 currentY)
+template <typename cInt>
+cInt TopX(TEdge< cInt > &edge, const cInt currentY)
 {
   if( currentY == edge.ytop ) return edge.xtop;
   return edge.xbot + Round(edge.dx *(currentY - edge.ybot));
 }
 //------------------------------------------------------------------------------
 
-long64 TopX(const IntPoint pt1, const IntPoint pt2, const long64 currentY)
+template <typename cInt>
+cInt TopX(const TIntPoint< cInt > pt1, const TIntPoint< cInt > pt2,
+  const cInt currentY)
 {
   //preconditions: pt1.Y <> pt2.Y and pt1.Y > pt2.Y
   if (currentY >= pt1.Y) return pt1.X;
@@ -509,13 +558,14 @@ long64 TopX(const IntPoint pt1, const IntPoint pt2, const long64 currentY)
   else
   {
     double q = (double)(pt1.X-pt2.X)/(double)(pt1.Y-pt2.Y);
-    return static_cast<long64>(pt1.X + (currentY - pt1.Y) *q);
+    return static_cast< cInt >(pt1.X + (currentY - pt1.Y) *q);
   }
 }
 //------------------------------------------------------------------------------
 
-bool IntersectPoint(TEdge &edge1, TEdge &edge2,
-  IntPoint &ip, bool UseFullInt64Range)
+template <typename cInt>
+bool IntersectPoint(TEdge< cInt > &edge1, TEdge< cInt > &edge2,
+  TIntPoint< cInt > &ip, bool UseFullInt64Range)
 {
   double b1, b2;
   if (SlopesEqual(edge1, edge2, UseFullInt64Range)) return false;
@@ -559,9 +609,10 @@ bool IntersectPoint(TEdge &edge1, TEdge &edge2,
 }
 //------------------------------------------------------------------------------
 
-void ReversePolyPtLinks(PolyPt &pp)
+template <typename cInt>
+void ReversePolyPtLinks(PolyPt< cInt > &pp)
 {
-  PolyPt *pp1, *pp2;
+  PolyPt< cInt > *pp1, *pp2;
   pp1 = &pp;
   do {
   pp2 = pp1->next;
@@ -572,23 +623,19 @@ void ReversePolyPtLinks(PolyPt &pp)
 }
 //------------------------------------------------------------------------------
 
-void DisposePolyPts(PolyPt*& pp)
+template <typename cInt>
+void DisposePolyPts(PolyPt< cInt >*& pp)
 {
-  if (pp == 0) return;
-  pp->prev->next = 0;
-  while( pp )
-  {
-    PolyPt *tmpPp = pp;
-    pp = pp->next;
-    delete tmpPp ;
-  }
+  //the points themselves belong to the execute arena ...
+  pp = 0;
 }
 //------------------------------------------------------------------------------
 
-void InitEdge(TEdge *e, TEdge *eNext,
-  TEdge *ePrev, const IntPoint &pt, PolyType polyType)
+template <typename cInt>
+void InitEdge(TEdge< cInt > *e, TEdge< cInt > *eNext,
+  TEdge< cInt > *ePrev, const TIntPoint< cInt > &pt, PolyType polyType)
 {
-  std::memset( e, 0, sizeof( TEdge ));
+  std::memset( e, 0, sizeof( TEdge< cInt > ));
 
   e->next = eNext;
   e->prev = ePrev;
@@ -615,7 +662,8 @@ void InitEdge(TEdge *e, TEdge *eNext,
 }
 //------------------------------------------------------------------------------
 
-inline void SwapX(TEdge &e)
+template <typename cInt>
+inline void SwapX(TEdge< cInt > &e)
 {
   //swap horizontal edges' top and bottom x's so they follow the natural
   //progression of the bounds - ie so their xbots will align with the
@@ -626,16 +674,19 @@ inline void SwapX(TEdge &e)
 }
 //------------------------------------------------------------------------------
 
-void SwapPoints(IntPoint &pt1, IntPoint &pt2)
+template <typename cInt>
+void SwapPoints(TIntPoint< cInt > &pt1, TIntPoint< cInt > &pt2)
 {
-  IntPoint tmp = pt1;
+  TIntPoint< cInt > tmp = pt1;
   pt1 = pt2;
   pt2 = tmp;
 }
 //------------------------------------------------------------------------------
 
-bool GetOverlapSegment(IntPoint pt1a, IntPoint pt1b, IntPoint pt2a,
-  IntPoint pt2b, IntPoint &pt1, IntPoint &pt2)
+template <typename cInt>
+bool GetOverlapSegment(TIntPoint< cInt > pt1a, TIntPoint< cInt > pt1b,
+  TIntPoint< cInt > pt2a, TIntPoint< cInt > pt2b,
+  TIntPoint< cInt > &pt1, TIntPoint< cInt > &pt2)
 {
   //precondition: segments are colinear.
   if ( pt1a.Y == pt1b.Y || Abs((pt1a.X - pt1b.X)/(pt1a.Y - pt1b.Y)) > 1 )
@@ -656,10 +707,11 @@ bool GetOverlapSegment(IntPoint pt1a, IntPoint pt1b, IntPoint pt2a,
 }
 //------------------------------------------------------------------------------
 
-PolyPt* PolygonBottom(PolyPt* pp)
+template <typename cInt>
+PolyPt< cInt >* PolygonBottom(PolyPt< cInt >* pp)
 {
-  PolyPt* p = pp->next;
-  PolyPt* result = pp;
+  PolyPt< cInt >* p = pp->next;
+  PolyPt< cInt >* result = pp;
   while (p != pp)
   {
     if (p->pt.Y > result->pt.Y) result = p;
@@ -670,12 +722,14 @@ PolyPt* PolygonBottom(PolyPt* pp)
 }
 //------------------------------------------------------------------------------
 
-bool FindSegment(PolyPt* &pp, IntPoint &pt1, IntPoint &pt2)
+template <typename cInt>
+bool FindSegment(PolyPt< cInt >* &pp,
+  TIntPoint< cInt > &pt1, TIntPoint< cInt > &pt2)
 {
   //outPt1 & outPt2 => the overlap segment (if the function returns true)
   if (!pp) return false;
-  PolyPt* pp2 = pp;
-  IntPoint pt1a = pt1, pt2a = pt2;
+  PolyPt< cInt >* pp2 = pp;
+  TIntPoint< cInt > pt1a = pt1, pt2a = pt2;
   do
   {
     if (SlopesEqual(pt1a, pt2a, pp->pt, pp->prev->pt, true) &&
@@ -689,8 +743,9 @@ bool FindSegment(PolyPt* &pp, IntPoint &pt1, IntPoint &pt2)
 }
 //------------------------------------------------------------------------------
 
-bool Pt3IsBetweenPt1AndPt2(const IntPoint pt1,
-  const IntPoint pt2, const IntPoint pt3)
+template <typename cInt>
+bool Pt3IsBetweenPt1AndPt2(const TIntPoint< cInt > pt1,
+  const TIntPoint< cInt > pt2, const TIntPoint< cInt > pt3)
 {
   if (PointsEqual(pt1, pt3) || PointsEqual(pt2, pt3)) return true;
   else if (pt1.X != pt2.X) return (pt1.X < pt3.X) == (pt3.X < pt2.X);
@@ -698,9 +753,11 @@ bool Pt3IsBetweenPt1AndPt2(const IntPoint pt1,
 }
 //------------------------------------------------------------------------------
 
-PolyPt* InsertPolyPtBetween(PolyPt* p1, PolyPt* p2, const IntPoint pt)
+template <typename cInt>
+PolyPt< cInt >* InsertPolyPtBetween(Arena &arena,
+  PolyPt< cInt >* p1, PolyPt< cInt >* p2, const TIntPoint< cInt > pt)
 {
-  PolyPt* result = new PolyPt;
+  PolyPt< cInt >* result = arena.New< PolyPt< cInt > >();
   result->pt = pt;
   result->isHole = p1->isHole;
   if (p2 == p1->next)
@@ -719,52 +776,116 @@ PolyPt* InsertPolyPtBetween(PolyPt* p1, PolyPt* p2, const IntPoint pt)
   return result;
 }
 
+//------------------------------------------------------------------------------
+// Arena methods ...
+//------------------------------------------------------------------------------
+
+//blocks are at least this big and allocations are rounded up to a multiple
+//of the alignment (enough for long64, double and pointers) ...
+static const std::size_t arenaBlockSize = 4096;
+static const std::size_t arenaAlignment = 16;
+
+Arena::Arena(): m_used(0), m_total(0) {}
+//------------------------------------------------------------------------------
+
+Arena::~Arena()
+{
+  for (std::vector< Block >::size_type i = 0; i < m_blocks.size(); ++i)
+    std::free(m_blocks[i].data);
+}
+//------------------------------------------------------------------------------
+
+void* Arena::Allocate(std::size_t size)
+{
+  size = (size + arenaAlignment - 1) & ~(arenaAlignment - 1);
+  if (m_blocks.empty() || m_used + size > m_blocks.back().size)
+  {
+    Block block;
+    //the first block after a Reset() is big enough for the previous round ...
+    if (m_blocks.empty())
+      block.size = std::max(std::max(arenaBlockSize, m_total), size); else
+      block.size = std::max(arenaBlockSize, size);
+    block.data = static_cast<char*>(std::malloc(block.size));
+    if (!block.data) throw std::bad_alloc();
+    if (m_blocks.empty()) m_total = 0;
+    m_blocks.push_back(block);
+    m_total += block.size;
+    m_used = 0;
+  }
+  void* result = m_blocks.back().data + m_used;
+  m_used += size;
+  return result;
+}
+//------------------------------------------------------------------------------
+
+void Arena::Reset()
+{
+  //keep a single block, otherwise free them all and let the next Allocate()
+  //replace them with one block of the same total size ...
+  m_used = 0;
+  if (m_blocks.size() <= 1) return;
+  for (std::vector< Block >::size_type i = 0; i < m_blocks.size(); ++i)
+    std::free(m_blocks[i].data);
+  m_blocks.clear();
+}
+
 //------------------------------------------------------------------------------
 // ClipperBase class methods ...
 //------------------------------------------------------------------------------
 
-ClipperBase::ClipperBase() //constructor
+template <typename cInt>
+ClipperBaseT< cInt >::ClipperBaseT() //constructor
 {
   m_MinimaList = 0;
   m_CurrentLM = 0;
-  m_UseFullRange = true;
+  m_UseFullRange = CoordTraits< cInt >::wide;
 }
 //------------------------------------------------------------------------------
 
-ClipperBase::~ClipperBase() //destructor
+template <typename cInt>
+ClipperBaseT< cInt >::~ClipperBaseT() //destructor
 {
   Clear();
 }
 //------------------------------------------------------------------------------
 
-void ClipperBase::UseFullCoordinateRange(bool newVal)
+template <typename cInt>
+void ClipperBaseT< cInt >::UseFullCoordinateRange(bool newVal)
 {
   if (m_edges.size() > 0 && newVal == true)
     throw clipperException("UseFullCoordinateRange() can't be changed "
       "until the Clipper object has been cleared.");
-  m_UseFullRange = newVal;
+  m_UseFullRange = newVal && CoordTraits< cInt >::wide;
 };
 //------------------------------------------------------------------------------
 
-bool ClipperBase::AddPolygon( const Polygon &pg, PolyType polyType)
+template <typename cInt>
+bool ClipperBaseT< cInt >::AddPolygon( const Polygon &pg, PolyType polyType)
 {
   int len = pg.size();
   if (len < 3) return false;
-  Polygon p(len);
-  p[0] = pg[0];
-  int j = 0;
-  const long64 MaxVal = 1500000000; //~ Sqrt(2^63)/2
+  //convert to the coordinate type in a buffer that's reused to avoid an
+  //allocation per polygon ...
+  std::vector< Point > &p = m_PolyBuffer;
+  p.resize(len);
+  const long64 MaxVal = CoordTraits< cInt >::loRange;
+  bool checkRange = !UseInt128< cInt >(m_UseFullRange);
+  for (int i = 0; i < len; ++i)
+  {
+    if (checkRange && (Abs(pg[i].X) > MaxVal || Abs(pg[i].Y) > MaxVal))
+      throw clipperException("Integer exceeds range bounds");
+    p[i] = Point((cInt)pg[i].X, (cInt)pg[i].Y);
+  }
 
+  int j = 0;
   for (int i = 1; i < len; ++i)
   {
-    if (!m_UseFullRange && (Abs(pg[i].X) > MaxVal || Abs(pg[i].Y) > MaxVal))
-      throw clipperException("Integer exceeds range bounds");
-    else if (PointsEqual(p[j], pg[i])) continue;
-    else if (j > 0 && SlopesEqual(p[j-1], p[j], pg[i], m_UseFullRange))
+    if (PointsEqual(p[j], p[i])) continue;
+    else if (j > 0 && SlopesEqual(p[j-1], p[j], p[i], m_UseFullRange))
     {
-      if (PointsEqual(p[j-1], pg[i])) j--;
+      if (PointsEqual(p[j-1], p[i])) j--;
     } else j++;
-    p[j] = pg[i];
+    p[j] = p[i];
   }
   if (j < 2) return false;
 
@@ -789,7 +910,7 @@ bool ClipperBase::AddPolygon( const Polygon &pg, PolyType polyType)
   if (len < 3) return false;
 
   //create a new edge array ...
-  TEdge *edges = new TEdge [len];
+  TEdge *edges = m_EdgeArena.NewArray<TEdge>(len);
   m_edges.push_back(edges);
 
   //convert vertices to a double-linked-list of edges and initialize ...
@@ -827,7 +948,8 @@ bool ClipperBase::AddPolygon( const Polygon &pg, PolyType polyType)
 }
 //------------------------------------------------------------------------------
 
-void ClipperBase::InsertLocalMinima(LocalMinima *newLm)
+template <typename cInt>
+void ClipperBaseT< cInt >::InsertLocalMinima(LocalMinima *newLm)
 {
   if( ! m_MinimaList )
   {
@@ -848,7 +970,8 @@ void ClipperBase::InsertLocalMinima(LocalMinima *newLm)
 }
 //------------------------------------------------------------------------------
 
-TEdge* ClipperBase::AddBoundsToLML(TEdge *e)
+template <typename cInt>
+TEdge< cInt >* ClipperBaseT< cInt >::AddBoundsToLML(TEdge *e)
 {
   //Starting at the top of one bound we progress to the bottom where there's
   //a local minima. We then go to the top of the next bound. These two bounds
@@ -872,7 +995,7 @@ TEdge* ClipperBase::AddBoundsToLML(TEdge *e)
   }
 
   //e and e.prev are now at a local minima ...
-  LocalMinima* newLm = new LocalMinima;
+  LocalMinima* newLm = m_EdgeArena.New<LocalMinima>();
   newLm->next = 0;
   newLm->Y = e->prev->ybot;
 
@@ -905,7 +1028,8 @@ TEdge* ClipperBase::AddBoundsToLML(TEdge *e)
 }
 //------------------------------------------------------------------------------
 
-bool ClipperBase::AddPolygons(const Polygons &ppg, PolyType polyType)
+template <typename cInt>
+bool ClipperBaseT< cInt >::AddPolygons(const Polygons &ppg, PolyType polyType)
 {
   bool result = false;
   for (Polygons::size_type i = 0; i < ppg.size(); ++i)
@@ -914,15 +1038,60 @@ bool ClipperBase::AddPolygons(const Polygons &ppg, PolyType polyType)
 }
 //------------------------------------------------------------------------------
 
-void ClipperBase::Clear()
+template <typename cInt>
+bool ClipperBaseT< cInt >::AddPrepared(PreparedPolygonT< cInt > &pg,
+  PolyType polyType)
+{
+  if (!pg.m_MinimaList) return false;
+  const long64 MaxVal = CoordTraits< cInt >::loRange;
+  if (!UseInt128< cInt >(m_UseFullRange) &&
+    (Abs(pg.m_Bounds.left) > MaxVal || Abs(pg.m_Bounds.right) > MaxVal ||
+    Abs(pg.m_Bounds.top) > MaxVal || Abs(pg.m_Bounds.bottom) > MaxVal))
+      throw clipperException("Integer exceeds range bounds");
+
+  //merge copies of pg's local minima into this list. Where Ys are equal pg's
+  //come first, just as if they had been added one at a time with
+  //InsertLocalMinima() ...
+  //InsertLocalMinimaIntoAEL() changes the windDelta of even-odd filled edges
+  //so they are restored (in the order Prepare() saved them) as well ...
+  LocalMinima **link = &m_MinimaList;
+  std::vector< int >::const_iterator windDelta = pg.m_WindDeltas.begin();
+  for (LocalMinima *lm = pg.m_MinimaList; lm; lm = lm->next)
+  {
+    TEdge *e;
+    for (e = lm->leftBound; e; e = e->nextInLML)
+    {
+      e->polyType = polyType;
+      e->windDelta = *windDelta++;
+    }
+    for (e = lm->rightBound; e; e = e->nextInLML)
+    {
+      e->polyType = polyType;
+      e->windDelta = *windDelta++;
+    }
+
+    while (*link && (*link)->Y > lm->Y) link = &(*link)->next;
+    LocalMinima* newLm = m_EdgeArena.New<LocalMinima>();
+    *newLm = *lm;
+    newLm->next = *link;
+    *link = newLm;
+    link = &newLm->next;
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+
+template <typename cInt>
+void ClipperBaseT< cInt >::Clear()
 {
   DisposeLocalMinimaList();
-  for (EdgeList::size_type i = 0; i < m_edges.size(); ++i) delete [] m_edges[i];
   m_edges.clear();
+  m_EdgeArena.Reset();
 }
 //------------------------------------------------------------------------------
 
-void ClipperBase::Reset()
+template <typename cInt>
+void ClipperBaseT< cInt >::Reset()
 {
   m_CurrentLM = m_MinimaList;
   if( !m_CurrentLM ) return; //ie nothing to process
@@ -954,26 +1123,25 @@ void ClipperBase::Reset()
 }
 //------------------------------------------------------------------------------
 
-void ClipperBase::DisposeLocalMinimaList()
+template <typename cInt>
+void ClipperBaseT< cInt >::DisposeLocalMinimaList()
 {
-  while( m_MinimaList )
-  {
-    LocalMinima* tmpLm = m_MinimaList->next;
-    delete m_MinimaList;
-    m_MinimaList = tmpLm;
-  }
+  //the nodes themselves belong to the edge arena ...
+  m_MinimaList = 0;
   m_CurrentLM = 0;
 }
 //------------------------------------------------------------------------------
 
-void ClipperBase::PopLocalMinima()
+template <typename cInt>
+void ClipperBaseT< cInt >::PopLocalMinima()
 {
   if( ! m_CurrentLM ) return;
   m_CurrentLM = m_CurrentLM->next;
 }
 //------------------------------------------------------------------------------
 
-IntRect ClipperBase::GetBounds()
+template <typename cInt>
+IntRect ClipperBaseT< cInt >::GetBounds()
 {
   IntRect result;
   LocalMinima* lm = m_MinimaList;
@@ -1013,40 +1181,70 @@ IntRect ClipperBase::GetBounds()
 }
 
 
+//------------------------------------------------------------------------------
+// PreparedPolygon methods ...
+//------------------------------------------------------------------------------
+
+template <typename cInt>
+PreparedPolygonT< cInt >::PreparedPolygonT() : ClipperBaseT< cInt >(), m_Area(0)
+{
+  m_Bounds.left = m_Bounds.top = m_Bounds.right = m_Bounds.bottom = 0;
+}
+//------------------------------------------------------------------------------
+
+template <typename cInt>
+bool PreparedPolygonT< cInt >::Prepare(const Polygon &pg)
+{
+  this->Clear();
+  bool result = this->AddPolygon(pg, ptSubject);
+  m_Area = result ? std::fabs(clipper::Area(pg, this->m_UseFullRange)) : 0;
+  m_Bounds = this->GetBounds();
+
+  m_WindDeltas.clear();
+  for (LocalMinima< cInt > *lm = this->m_MinimaList; lm; lm = lm->next)
+  {
+    TEdge< cInt > *e;
+    for (e = lm->leftBound; e; e = e->nextInLML)
+      m_WindDeltas.push_back(e->windDelta);
+    for (e = lm->rightBound; e; e = e->nextInLML)
+      m_WindDeltas.push_back(e->windDelta);
+  }
+  return result;
+}
+
 //------------------------------------------------------------------------------
 // TClipper methods ...
 //------------------------------------------------------------------------------
 
-Clipper::Clipper() : ClipperBase() //constructor
+template <typename cInt>
+ClipperT< cInt >::ClipperT() : ClipperBaseT< cInt >() //constructor
 {
-  m_Scanbeam = 0;
   m_ActiveEdges = 0;
   m_SortedEdges = 0;
-  m_IntersectNodes = 0;
+  m_IntersectMaxY = 0;
   m_ExecuteLocked = false;
 };
 //------------------------------------------------------------------------------
 
-Clipper::~Clipper() //destructor
+template <typename cInt>
+ClipperT< cInt >::~ClipperT() //destructor
 {
   DisposeScanbeamList();
 };
 //------------------------------------------------------------------------------
 
-void Clipper::DisposeScanbeamList()
+template <typename cInt>
+void ClipperT< cInt >::DisposeScanbeamList()
 {
-  while ( m_Scanbeam ) {
-  Scanbeam* sb2 = m_Scanbeam->next;
-  delete m_Scanbeam;
-  m_Scanbeam = sb2;
-  }
+  m_Scanbeam.clear();
 }
 //------------------------------------------------------------------------------
 
-void Clipper::Reset()
+template <typename cInt>
+void ClipperT< cInt >::Reset()
 {
-  ClipperBase::Reset();
-  m_Scanbeam = 0;
+  Base::Reset();
+  m_Scanbeam.clear();
   m_ActiveEdges = 0;
   m_SortedEdges = 0;
   LocalMinima* lm = m_MinimaList;
@@ -1059,97 +1257,145 @@ void Clipper::Reset()
 }
 //------------------------------------------------------------------------------
 
-bool Clipper::Execute(ClipType clipType, Polygons &solution,
+template <typename cInt>
+bool ClipperT< cInt >::Execute(ClipType clipType, Polygons &solution,
+    PolyFillType subjFillType, PolyFillType clipFillType)
+{
+  if( m_ExecuteLocked ) return false;
+  m_ExecuteLocked = true;
+  bool succeeded = Sweep(clipType, subjFillType, clipFillType);
+  try {
+    //build the return polygons (reusing the solution's storage) ...
+    if (succeeded) BuildResult(solution);
+  }
+  catch(...) {
+    succeeded = false;
+  }
+  if (!succeeded) solution.resize(0);
+  DisposeExecuteData();
+  m_ExecuteLocked = false;
+  return succeeded;
+}
+//------------------------------------------------------------------------------
+
+template <typename cInt>
+bool ClipperT< cInt >::ExecuteArea(ClipType clipType, double &area,
     PolyFillType subjFillType, PolyFillType clipFillType)
 {
   if( m_ExecuteLocked ) return false;
+  m_ExecuteLocked = true;
+  bool succeeded = Sweep(clipType, subjFillType, clipFillType);
+  try {
+    area = succeeded ? ResultArea() : 0;
+  }
+  catch(...) {
+    succeeded = false;
+  }
+  if (!succeeded) area = 0;
+  DisposeExecuteData();
+  m_ExecuteLocked = false;
+  return succeeded;
+}
+//------------------------------------------------------------------------------
+
+template <typename cInt>
+bool ClipperT< cInt >::Sweep(ClipType clipType,
+    PolyFillType subjFillType, PolyFillType clipFillType)
+{
   bool succeeded;
   try {
-    m_ExecuteLocked = true;
-    solution.resize(0);
     Reset();
-    if (!m_CurrentLM )
-    {
-      m_ExecuteLocked = false;
-      return true;
-    }
+    if (!m_CurrentLM ) return true;
     m_SubjFillType = subjFillType;
     m_ClipFillType = clipFillType;
     m_ClipType = clipType;
 
-    long64 botY = PopScanbeam();
+    cInt botY = PopScanbeam();
     do {
       InsertLocalMinimaIntoAEL(botY);
       ClearHorzJoins();
       ProcessHorizontals();
-      long64 topY = PopScanbeam();
+      cInt topY = PopScanbeam();
       succeeded = ProcessIntersections(topY);
       if (succeeded) ProcessEdgesAtTopOfScanbeam(topY);
       botY = topY;
-    } while( succeeded && m_Scanbeam );
-
-    //build the return polygons ...
-    if (succeeded) BuildResult(solution);
+    } while( succeeded && !m_Scanbeam.empty() );
   }
   catch(...) {
-    ClearJoins();
-    ClearHorzJoins();
-    solution.resize(0);
     succeeded = false;
   }
+  return succeeded;
+}
+//------------------------------------------------------------------------------
+
+template <typename cInt>
+void ClipperT< cInt >::DisposeExecuteData()
+{
   ClearJoins();
   ClearHorzJoins();
   DisposeAllPolyPts();
-  m_ExecuteLocked = false;
-  return succeeded;
+  DisposeScanbeamList();
+  DisposeIntersectNodes();
+  m_ExecuteArena.Reset();
 }
 //------------------------------------------------------------------------------
 
-void Clipper::InsertScanbeam(const long64 Y)
+template <typename cInt>
+double ClipperT< cInt >::ResultArea()
 {
-  if( !m_Scanbeam )
-  {
-    m_Scanbeam = new Scanbeam;
-    m_Scanbeam->next = 0;
-    m_Scanbeam->Y = Y;
-  }
-  else if(  Y > m_Scanbeam->Y )
-  {
-    Scanbeam* newSb = new Scanbeam;
-    newSb->Y = Y;
-    newSb->next = m_Scanbeam;
-    m_Scanbeam = newSb;
-  } else
-  {
-    Scanbeam* sb2 = m_Scanbeam;
-    while( sb2->next  && ( Y <= sb2->next->Y ) ) sb2 = sb2->next;
-    if(  Y == sb2->Y ) return; //ie ignores duplicates
-    Scanbeam* newSb = new Scanbeam;
-    newSb->Y = Y;
-    newSb->next = sb2->next;
-    sb2->next = newSb;
-  }
+  //the polygons are fixed up and joined exactly as BuildResult() does, the
+  //joins can split polygons and change their hole state. Each area is then
+  //summed in the same order as Area(poly, false) sums the built polygon ...
+  FixupResult();
+  double area = 0;
+  for (typename PolyPtList::size_type i = 0; i < m_PolyPts.size(); ++i)
+    if (m_PolyPts[i])
+    {
+      PolyPt *first = m_PolyPts[i], *last = first->prev;
+      //BuildResult() drops polygons with less than 3 vertices ...
+      if (first->next == last || first == last) continue;
+      double a = (double)(last->pt.X) * (double)(first->pt.Y) -
+        (double)(first->pt.X) * (double)(last->pt.Y);
+      for (PolyPt *p = first; p != last; p = p->next)
+        a += (double)(p->pt.X) * (double)(p->next->pt.Y) -
+          (double)(p->next->pt.X) * (double)(p->pt.Y);
+      area += a/2;
+    }
+  return area;
+}
+//------------------------------------------------------------------------------
+
+template <typename cInt>
+void ClipperT< cInt >::InsertScanbeam(const cInt Y)
+{
+  //duplicates are kept and skipped by PopScanbeam() ...
+  m_Scanbeam.push_back(Y);
+  std::push_heap(m_Scanbeam.begin(), m_Scanbeam.end());
 }
 //------------------------------------------------------------------------------
 
-long64 Clipper::PopScanbeam()
+template <typename cInt>
+cInt ClipperT< cInt >::PopScanbeam()
 {
-  long64 Y = m_Scanbeam->Y;
-  Scanbeam* sb2 = m_Scanbeam;
-  m_Scanbeam = m_Scanbeam->next;
-  delete sb2;
+  cInt Y = m_Scanbeam.front();
+  do {
+    std::pop_heap(m_Scanbeam.begin(), m_Scanbeam.end());
+    m_Scanbeam.pop_back();
+  } while ( !m_Scanbeam.empty() && m_Scanbeam.front() == Y );
   return Y;
 }
 //------------------------------------------------------------------------------
 
-void Clipper::DisposeAllPolyPts(){
-  for (PolyPtList::size_type i = 0; i < m_PolyPts.size(); ++i)
+template <typename cInt>
+void ClipperT< cInt >::DisposeAllPolyPts(){
+  for (typename PolyPtList::size_type i = 0; i < m_PolyPts.size(); ++i)
     DisposePolyPts(m_PolyPts[i]);
   m_PolyPts.clear();
 }
 //------------------------------------------------------------------------------
 
-void Clipper::SetWindingCount(TEdge &edge)
+template <typename cInt>
+void ClipperT< cInt >::SetWindingCount(TEdge &edge)
 {
   TEdge *e = edge.prevInAEL;
   //find the edge of the same polytype that immediately preceeds 'edge' in AEL
@@ -1209,7 +1455,8 @@ void Clipper::SetWindingCount(TEdge &edge)
 }
 //------------------------------------------------------------------------------
 
-bool Clipper::IsNonZeroFillType(const TEdge& edge) const
+template <typename cInt>
+bool ClipperT< cInt >::IsNonZeroFillType(const TEdge& edge) const
 {
   if (edge.polyType == ptSubject)
     return m_SubjFillType == pftNonZero; else
@@ -1217,7 +1464,8 @@ bool Clipper::IsNonZeroFillType(const TEdge& edge) const
 }
 //------------------------------------------------------------------------------
 
-bool Clipper::IsNonZeroAltFillType(const TEdge& edge) const
+template <typename cInt>
+bool ClipperT< cInt >::IsNonZeroAltFillType(const TEdge& edge) const
 {
   if (edge.polyType == ptSubject)
     return m_ClipFillType == pftNonZero; else
@@ -1225,7 +1473,8 @@ bool Clipper::IsNonZeroAltFillType(const TEdge& edge) const
 }
 //------------------------------------------------------------------------------
 
-bool Clipper::IsContributing(const TEdge& edge) const
+template <typename cInt>
+bool ClipperT< cInt >::IsContributing(const TEdge& edge) const
 {
   switch( m_ClipType ){
     case ctIntersection:
@@ -1244,7 +1493,8 @@ bool Clipper::IsContributing(const TEdge& edge) const
 }
 //------------------------------------------------------------------------------
 
-void Clipper::AddLocalMinPoly(TEdge *e1, TEdge *e2, const IntPoint &pt)
+template <typename cInt>
+void ClipperT< cInt >::AddLocalMinPoly(TEdge *e1, TEdge *e2, const Point &pt)
 {
   if( e2->dx == horizontal || ( e1->dx > e2->dx ) )
   {
@@ -1262,7 +1512,8 @@ void Clipper::AddLocalMinPoly(TEdge *e1, TEdge *e2, const IntPoint &pt)
 }
 //------------------------------------------------------------------------------
 
-void Clipper::AddLocalMaxPoly(TEdge *e1, TEdge *e2, const IntPoint &pt)
+template <typename cInt>
+void ClipperT< cInt >::AddLocalMaxPoly(TEdge *e1, TEdge *e2, const Point &pt)
 {
   AddPolyPt( e1, pt );
   if( e1->outIdx == e2->outIdx )
@@ -1275,7 +1526,8 @@ void Clipper::AddLocalMaxPoly(TEdge *e1, TEdge *e2, const IntPoint &pt)
 }
 //------------------------------------------------------------------------------
 
-void Clipper::AddEdgeToSEL(TEdge *edge)
+template <typename cInt>
+void ClipperT< cInt >::AddEdgeToSEL(TEdge *edge)
 {
   //SEL pointers in PEdge are reused to build a list of horizontal edges.
   //However, we don't need to worry about order with horizontal edge processing.
@@ -1295,7 +1547,8 @@ void Clipper::AddEdgeToSEL(TEdge *edge)
 }
 //------------------------------------------------------------------------------
 
-void Clipper::CopyAELToSEL()
+template <typename cInt>
+void ClipperT< cInt >::CopyAELToSEL()
 {
   TEdge* e = m_ActiveEdges;
   m_SortedEdges = e;
@@ -1312,49 +1565,50 @@ void Clipper::CopyAELToSEL()
 }
 //------------------------------------------------------------------------------
 
-void Clipper::AddJoin(TEdge *e1, TEdge *e2, int e1OutIdx, int e2OutIdx)
+template <typename cInt>
+void ClipperT< cInt >::AddJoin(TEdge *e1, TEdge *e2, int e1OutIdx, int e2OutIdx)
 {
-  JoinRec* jr = new JoinRec;
+  JoinRec* jr = m_ExecuteArena.New<JoinRec>();
   if (e1OutIdx >= 0)
     jr->poly1Idx = e1OutIdx; else
     jr->poly1Idx = e1->outIdx;
-  jr->pt1a = IntPoint(e1->xcurr, e1->ycurr);
-  jr->pt1b = IntPoint(e1->xtop, e1->ytop);
+  jr->pt1a = Point(e1->xcurr, e1->ycurr);
+  jr->pt1b = Point(e1->xtop, e1->ytop);
   if (e2OutIdx >= 0)
     jr->poly2Idx = e2OutIdx; else
     jr->poly2Idx = e2->outIdx;
-  jr->pt2a = IntPoint(e2->xcurr, e2->ycurr);
-  jr->pt2b = IntPoint(e2->xtop, e2->ytop);
+  jr->pt2a = Point(e2->xcurr, e2->ycurr);
+  jr->pt2b = Point(e2->xtop, e2->ytop);
   m_Joins.push_back(jr);
 }
 //------------------------------------------------------------------------------
 
-void Clipper::ClearJoins()
+template <typename cInt>
+void ClipperT< cInt >::ClearJoins()
 {
-  for (JoinList::size_type i = 0; i < m_Joins.size(); i++)
-    delete m_Joins[i];
   m_Joins.resize(0);
 }
 //------------------------------------------------------------------------------
 
-void Clipper::AddHorzJoin(TEdge *e, int idx)
+template <typename cInt>
+void ClipperT< cInt >::AddHorzJoin(TEdge *e, int idx)
 {
-  HorzJoinRec* hj = new HorzJoinRec;
+  HorzJoinRec* hj = m_ExecuteArena.New<HorzJoinRec>();
   hj->edge = e;
   hj->savedIdx = idx;
   m_HorizJoins.push_back(hj);
 }
 //------------------------------------------------------------------------------
 
-void Clipper::ClearHorzJoins()
+template <typename cInt>
+void ClipperT< cInt >::ClearHorzJoins()
 {
-  for (HorzJoinList::size_type i = 0; i < m_HorizJoins.size(); i++)
-    delete m_HorizJoins[i];
   m_HorizJoins.resize(0);
 }
 //------------------------------------------------------------------------------
 
-void Clipper::InsertLocalMinimaIntoAEL( const long64 botY)
+template <typename cInt>
+void ClipperT< cInt >::InsertLocalMinimaIntoAEL( const cInt botY)
 {
   while(  m_CurrentLM  && ( m_CurrentLM->Y == botY ) )
   {
@@ -1386,7 +1640,7 @@ void Clipper::InsertLocalMinimaIntoAEL( const long64 botY)
       InsertScanbeam( rb->ytop );
 
     if( IsContributing(*lb) )
-      AddLocalMinPoly( lb, rb, IntPoint(lb->xcurr, m_CurrentLM->Y) );
+      AddLocalMinPoly( lb, rb, Point(lb->xcurr, m_CurrentLM->Y) );
 
     //if output polygons share an edge, they'll need joining later ...
     if (lb->outIdx >= 0 && lb->prevInAEL &&
@@ -1399,15 +1653,16 @@ void Clipper::InsertLocalMinimaIntoAEL( const long64 botY)
     {
       if (rb->dx == horizontal)
       {
-        for (HorzJoinList::size_type i = 0; i < m_HorizJoins.size(); ++i)
+        for (typename HorzJoinList::size_type i = 0;
+          i < m_HorizJoins.size(); ++i)
         {
-          IntPoint pt, pt2; //returned by GetOverlapSegment() but unused here.
+          Point pt, pt2; //returned by GetOverlapSegment() but unused here.
           HorzJoinRec* hj = m_HorizJoins[i];
           //if horizontals rb and hj.edge overlap, flag for joining later ...
-          if (GetOverlapSegment(IntPoint(hj->edge->xbot, hj->edge->ybot),
-            IntPoint(hj->edge->xtop, hj->edge->ytop),
-            IntPoint(rb->xbot, rb->ybot),
-            IntPoint(rb->xtop, rb->ytop), pt, pt2))
+          if (GetOverlapSegment(Point(hj->edge->xbot, hj->edge->ybot),
+            Point(hj->edge->xtop, hj->edge->ytop),
+            Point(rb->xbot, rb->ybot),
+            Point(rb->xtop, rb->ytop), pt, pt2))
               AddJoin(hj->edge, rb, hj->savedIdx);
         }
       }
@@ -1420,7 +1675,7 @@ void Clipper::InsertLocalMinimaIntoAEL( const long64 botY)
           AddJoin(rb, rb->prevInAEL);
 
       TEdge* e = lb->nextInAEL;
-      IntPoint pt = IntPoint(lb->xcurr, lb->ycurr);
+      Point pt = Point(lb->xcurr, lb->ycurr);
       while( e != rb )
       {
         if(!e) throw clipperException("InsertLocalMinimaIntoAEL: missing rightbound!");
@@ -1435,7 +1690,8 @@ void Clipper::InsertLocalMinimaIntoAEL( const long64 botY)
 }
 //------------------------------------------------------------------------------
 
-void Clipper::DeleteFromAEL(TEdge *e)
+template <typename cInt>
+void ClipperT< cInt >::DeleteFromAEL(TEdge *e)
 {
   TEdge* AelPrev = e->prevInAEL;
   TEdge* AelNext = e->nextInAEL;
@@ -1448,7 +1704,8 @@ void Clipper::DeleteFromAEL(TEdge *e)
 }
 //------------------------------------------------------------------------------
 
-void Clipper::DeleteFromSEL(TEdge *e)
+template <typename cInt>
+void ClipperT< cInt >::DeleteFromSEL(TEdge *e)
 {
   TEdge* SelPrev = e->prevInSEL;
   TEdge* SelNext = e->nextInSEL;
@@ -1461,8 +1718,9 @@ void Clipper::DeleteFromSEL(TEdge *e)
 }
 //------------------------------------------------------------------------------
 
-void Clipper::IntersectEdges(TEdge *e1, TEdge *e2,
-     const IntPoint &pt, IntersectProtects protects)
+template <typename cInt>
+void ClipperT< cInt >::IntersectEdges(TEdge *e1, TEdge *e2,
+     const Point &pt, IntersectProtects protects)
 {
   //e1 will be to the left of e2 BELOW the intersection. Therefore e1 is before
   //e2 in AEL except when e1 is being inserted at the intersection point ...
@@ -1570,9 +1828,10 @@ void Clipper::IntersectEdges(TEdge *e1, TEdge *e2,
 }
 //------------------------------------------------------------------------------
 
-void SetHoleState(PolyPt *pp, bool isHole)
+template <typename cInt>
+void SetHoleState(PolyPt< cInt > *pp, bool isHole)
 {
-  PolyPt *pp2 = pp;
+  PolyPt< cInt > *pp2 = pp;
   do
   {
     pp2->isHole = isHole;
@@ -1582,7 +1841,8 @@ void SetHoleState(PolyPt *pp, bool isHole)
 }
 //------------------------------------------------------------------------------
 
-void Clipper::AppendPolygon(TEdge *e1, TEdge *e2)
+template <typename cInt>
+void ClipperT< cInt >::AppendPolygon(TEdge *e1, TEdge *e2)
 {
   //get the start and ends of both output polygons ...
   PolyPt* p1_lft = m_PolyPts[e1->outIdx];
@@ -1669,13 +1929,13 @@ void Clipper::AppendPolygon(TEdge *e1, TEdge *e2)
     e = e->nextInAEL;
   }
 
-  for (JoinList::size_type i = 0; i < m_Joins.size(); ++i)
+  for (typename JoinList::size_type i = 0; i < m_Joins.size(); ++i)
   {
       if (m_Joins[i]->poly1Idx == ObsoleteIdx) m_Joins[i]->poly1Idx = OKIdx;
       if (m_Joins[i]->poly2Idx == ObsoleteIdx) m_Joins[i]->poly2Idx = OKIdx;
   }
 
-  for (HorzJoinList::size_type i = 0; i < m_HorizJoins.size(); ++i)
+  for (typename HorzJoinList::size_type i = 0; i < m_HorizJoins.size(); ++i)
   {
       if (m_HorizJoins[i]->savedIdx == ObsoleteIdx)
         m_HorizJoins[i]->savedIdx = OKIdx;
@@ -1684,12 +1944,13 @@ void Clipper::AppendPolygon(TEdge *e1, TEdge *e2)
 }
 //------------------------------------------------------------------------------
 
-PolyPt* Clipper::AddPolyPt(TEdge *e, const IntPoint &pt)
+template <typename cInt>
+PolyPt< cInt >* ClipperT< cInt >::AddPolyPt(TEdge *e, const Point &pt)
 {
   bool ToFront = (e->side == esLeft);
   if(  e->outIdx < 0 )
   {
-    PolyPt* newPolyPt = new PolyPt;
+    PolyPt* newPolyPt = m_ExecuteArena.New<PolyPt>();
     newPolyPt->pt = pt;
     newPolyPt->isHole = IsHole(e);
     m_PolyPts.push_back(newPolyPt);
@@ -1703,7 +1964,7 @@ PolyPt* Clipper::AddPolyPt(TEdge *e, const IntPoint &pt)
     if (ToFront && PointsEqual(pt, pp->pt)) return pp;
     if (!ToFront && PointsEqual(pt, pp->prev->pt)) return pp->prev;
 
-    PolyPt* newPolyPt = new PolyPt;
+    PolyPt* newPolyPt = m_ExecuteArena.New<PolyPt>();
     newPolyPt->pt = pt;
     newPolyPt->isHole = pp->isHole;
     newPolyPt->next = pp;
@@ -1716,7 +1977,8 @@ PolyPt* Clipper::AddPolyPt(TEdge *e, const IntPoint &pt)
 }
 //------------------------------------------------------------------------------
 
-void Clipper::ProcessHorizontals()
+template <typename cInt>
+void ClipperT< cInt >::ProcessHorizontals()
 {
   TEdge* horzEdge = m_SortedEdges;
   while( horzEdge )
@@ -1728,7 +1990,8 @@ void Clipper::ProcessHorizontals()
 }
 //------------------------------------------------------------------------------
 
-bool Clipper::IsTopHorz(const long64 XPos)
+template <typename cInt>
+bool ClipperT< cInt >::IsTopHorz(const cInt XPos)
 {
   TEdge* e = m_SortedEdges;
   while( e )
@@ -1741,25 +2004,29 @@ bool Clipper::IsTopHorz(const long64 XPos)
 }
 //------------------------------------------------------------------------------
 
-bool IsMinima(TEdge *e)
+template <typename cInt>
+bool IsMinima(TEdge< cInt > *e)
 {
   return e  && (e->prev->nextInLML != e) && (e->next->nextInLML != e);
 }
 //------------------------------------------------------------------------------
 
-bool IsMaxima(TEdge *e, const long64 Y)
+template <typename cInt>
+bool IsMaxima(TEdge< cInt > *e, const cInt Y)
 {
   return e && e->ytop == Y && !e->nextInLML;
 }
 //------------------------------------------------------------------------------
 
-bool IsIntermediate(TEdge *e, const long64 Y)
+template <typename cInt>
+bool IsIntermediate(TEdge< cInt > *e, const cInt Y)
 {
   return e->ytop == Y && e->nextInLML;
 }
 //------------------------------------------------------------------------------
 
-TEdge *GetMaximaPair(TEdge *e)
+template <typename cInt>
+TEdge< cInt > *GetMaximaPair(TEdge< cInt > *e)
 {
   if( !IsMaxima(e->next, e->ytop) || e->next->xtop != e->xtop )
     return e->prev; else
@@ -1767,7 +2034,8 @@ TEdge *GetMaximaPair(TEdge *e)
 }
 //------------------------------------------------------------------------------
 
-void Clipper::SwapPositionsInAEL(TEdge *edge1, TEdge *edge2)
+template <typename cInt>
+void ClipperT< cInt >::SwapPositionsInAEL(TEdge *edge1, TEdge *edge2)
 {
   if(  !edge1->nextInAEL &&  !edge1->prevInAEL ) return;
   if(  !edge2->nextInAEL &&  !edge2->prevInAEL ) return;
@@ -1813,7 +2081,8 @@ void Clipper::SwapPositionsInAEL(TEdge *edge1, TEdge *edge2)
 }
 //------------------------------------------------------------------------------
 
-void Clipper::SwapPositionsInSEL(TEdge *edge1, TEdge *edge2)
+template <typename cInt>
+void ClipperT< cInt >::SwapPositionsInSEL(TEdge *edge1, TEdge *edge2)
 {
   if(  !( edge1->nextInSEL ) &&  !( edge1->prevInSEL ) ) return;
   if(  !( edge2->nextInSEL ) &&  !( edge2->prevInSEL ) ) return;
@@ -1859,17 +2128,19 @@ void Clipper::SwapPositionsInSEL(TEdge *edge1, TEdge *edge2)
 }
 //------------------------------------------------------------------------------
 
-TEdge* GetNextInAEL(TEdge *e, Direction dir)
+template <typename cInt>
+TEdge< cInt >* GetNextInAEL(TEdge< cInt > *e, Direction dir)
 {
   if( dir == dLeftToRight ) return e->nextInAEL;
   else return e->prevInAEL;
 }
 //------------------------------------------------------------------------------
 
-void Clipper::ProcessHorizontal(TEdge *horzEdge)
+template <typename cInt>
+void ClipperT< cInt >::ProcessHorizontal(TEdge *horzEdge)
 {
   Direction dir;
-  long64 horzLeft, horzRight;
+  cInt horzLeft, horzRight;
 
   if( horzEdge->xcurr < horzEdge->xtop )
   {
@@ -1913,9 +2184,9 @@ void Clipper::ProcessHorizontal(TEdge *horzEdge)
       {
         //horzEdge is evidently a maxima horizontal and we've arrived at its end.
         if (dir == dLeftToRight)
-          IntersectEdges(horzEdge, e, IntPoint(e->xcurr, horzEdge->ycurr), ipNone);
+          IntersectEdges(horzEdge, e, Point(e->xcurr, horzEdge->ycurr), ipNone);
         else
-          IntersectEdges(e, horzEdge, IntPoint(e->xcurr, horzEdge->ycurr), ipNone);
+          IntersectEdges(e, horzEdge, Point(e->xcurr, horzEdge->ycurr), ipNone);
         return;
       }
       else if( e->dx == horizontal &&  !IsMinima(e) && !(e->xcurr > e->xtop) )
@@ -1925,20 +2196,20 @@ void Clipper::ProcessHorizontal(TEdge *horzEdge)
         //being infinitesimally lower that the next (e). Therfore, we
         //intersect with e only if e.xcurr is within the bounds of horzEdge ...
         if( dir == dLeftToRight )
-          IntersectEdges( horzEdge , e, IntPoint(e->xcurr, horzEdge->ycurr),
+          IntersectEdges( horzEdge , e, Point(e->xcurr, horzEdge->ycurr),
             (IsTopHorz( e->xcurr ))? ipLeft : ipBoth );
         else
-          IntersectEdges( e, horzEdge, IntPoint(e->xcurr, horzEdge->ycurr),
+          IntersectEdges( e, horzEdge, Point(e->xcurr, horzEdge->ycurr),
             (IsTopHorz( e->xcurr ))? ipRight : ipBoth );
       }
       else if( dir == dLeftToRight )
       {
-        IntersectEdges( horzEdge, e, IntPoint(e->xcurr, horzEdge->ycurr),
+        IntersectEdges( horzEdge, e, Point(e->xcurr, horzEdge->ycurr),
           (IsTopHorz( e->xcurr ))? ipLeft : ipBoth );
       }
       else
       {
-        IntersectEdges( e, horzEdge, IntPoint(e->xcurr, horzEdge->ycurr),
+        IntersectEdges( e, horzEdge, Point(e->xcurr, horzEdge->ycurr),
           (IsTopHorz( e->xcurr ))? ipRight : ipBoth );
       }
       SwapPositionsInAEL( horzEdge, e );
@@ -1953,14 +2224,14 @@ void Clipper::ProcessHorizontal(TEdge *horzEdge)
   if( horzEdge->nextInLML )
   {
     if( horzEdge->outIdx >= 0 )
-      AddPolyPt( horzEdge, IntPoint(horzEdge->xtop, horzEdge->ytop));
+      AddPolyPt( horzEdge, Point(horzEdge->xtop, horzEdge->ytop));
     UpdateEdgeIntoAEL( horzEdge );
   }
   else
   {
     if ( horzEdge->outIdx >= 0 )
       IntersectEdges( horzEdge, eMaxPair,
-      IntPoint(horzEdge->xtop, horzEdge->ycurr), ipBoth);
+      Point(horzEdge->xtop, horzEdge->ycurr), ipBoth);
     if (eMaxPair->outIdx >= 0) throw clipperException("ProcessHorizontal error");
     DeleteFromAEL(eMaxPair);
     DeleteFromAEL(horzEdge);
@@ -1968,7 +2239,8 @@ void Clipper::ProcessHorizontal(TEdge *horzEdge)
 }
 //------------------------------------------------------------------------------
 
-void Clipper::UpdateEdgeIntoAEL(TEdge *&e)
+template <typename cInt>
+void ClipperT< cInt >::UpdateEdgeIntoAEL(TEdge *&e)
 {
   if( !e->nextInLML ) throw
     clipperException("UpdateEdgeIntoAEL: invalid call");
@@ -1989,12 +2261,13 @@ void Clipper::UpdateEdgeIntoAEL(TEdge *&e)
 }
 //------------------------------------------------------------------------------
 
-bool Clipper::ProcessIntersections( const long64 topY)
+template <typename cInt>
+bool ClipperT< cInt >::ProcessIntersections( const cInt topY)
 {
   if( !m_ActiveEdges ) return true;
   try {
     BuildIntersectList(topY);
-    if ( !m_IntersectNodes) return true;
+    if ( m_IntersectNodes.empty() ) return true;
     if ( FixupIntersections() ) ProcessIntersectList();
     else return false;
   }
@@ -2007,18 +2280,15 @@ bool Clipper::ProcessIntersections( const long64 topY)
 }
 //------------------------------------------------------------------------------
 
-void Clipper::DisposeIntersectNodes()
+template <typename cInt>
+void ClipperT< cInt >::DisposeIntersectNodes()
 {
-  while ( m_IntersectNodes )
-  {
-    IntersectNode* iNode = m_IntersectNodes->next;
-    delete m_IntersectNodes;
-    m_IntersectNodes = iNode;
-  }
+  m_IntersectNodes.clear();
 }
 //------------------------------------------------------------------------------
 
-void Clipper::BuildIntersectList(const long64 topY)
+template <typename cInt>
+void ClipperT< cInt >::BuildIntersectList(const cInt topY)
 {
   if ( !m_ActiveEdges ) return;
 
@@ -2046,7 +2316,7 @@ void Clipper::BuildIntersectList(const long64 topY)
     while( e->nextInSEL )
     {
       TEdge *eNext = e->nextInSEL;
-      IntPoint pt;
+      Point pt;
       if(e->tmpX > eNext->tmpX &&
         IntersectPoint(*e, *eNext, pt, m_UseFullRange))
       {
@@ -2061,10 +2331,12 @@ void Clipper::BuildIntersectList(const long64 topY)
     else break;
   }
   m_SortedEdges = 0;
+  SortIntersectNodes();
 }
 //------------------------------------------------------------------------------
 
-bool Process1Before2(IntersectNode &node1, IntersectNode &node2)
+template <typename cInt>
+bool Process1Before2(IntersectNode< cInt > &node1, IntersectNode< cInt > &node2)
 {
   bool result;
   if (node1.pt.Y == node2.pt.Y)
@@ -2085,55 +2357,105 @@ bool Process1Before2(IntersectNode &node1, IntersectNode &node2)
 }
 //------------------------------------------------------------------------------
 
-void Clipper::AddIntersectNode(TEdge *e1, TEdge *e2, const IntPoint &pt)
+template <typename cInt>
+void ClipperT< cInt >::AddIntersectNode(TEdge *e1, TEdge *e2, const Point &pt)
 {
-  IntersectNode* newNode = new IntersectNode;
-  newNode->edge1 = e1;
-  newNode->edge2 = e2;
-  newNode->pt = pt;
-  newNode->next = 0;
-  if( !m_IntersectNodes ) m_IntersectNodes = newNode;
-  else if(  Process1Before2(*newNode, *m_IntersectNodes) )
-  {
-    newNode->next = m_IntersectNodes;
-    m_IntersectNodes = newNode;
-  }
-  else
-  {
-    IntersectNode* iNode = m_IntersectNodes;
-    while( iNode->next  && Process1Before2(*iNode->next, *newNode) )
-        iNode = iNode->next;
-    newNode->next = iNode->next;
-    iNode->next = newNode;
-  }
+  IntersectNode newNode;
+  newNode.edge1 = e1;
+  newNode.edge2 = e2;
+  newNode.pt = pt;
+  newNode.order = (int)m_IntersectNodes.size();
+  newNode.followsLargerY =
+    !m_IntersectNodes.empty() && m_IntersectMaxY > pt.Y;
+  if ( m_IntersectNodes.empty() || pt.Y > m_IntersectMaxY )
+    m_IntersectMaxY = pt.Y;
+  m_IntersectNodes.push_back(newNode);
+}
+//------------------------------------------------------------------------------
+
+template <typename cInt>
+bool IntersectNodeYGreater(const IntersectNode< cInt > &node1,
+  const IntersectNode< cInt > &node2)
+{
+  if (node1.pt.Y != node2.pt.Y) return node1.pt.Y > node2.pt.Y;
+  else return node1.order < node2.order;
 }
 //------------------------------------------------------------------------------
 
-void Clipper::ProcessIntersectList()
+template <typename cInt>
+void ClipperT< cInt >::SortIntersectNodes()
 {
-  while( m_IntersectNodes )
+  //Nodes are sorted in the order that inserting them one at a time into a
+  //sorted list (with Process1Before2) would produce. Process1Before2 only
+  //looks at Y when the Ys differ, so sorting on Y (then on the order the
+  //nodes were added) does most of the work. Nodes sharing a Y are then
+  //re-inserted in their original order. A node added while a larger Y was in
+  //the list was compared against every node of its group, otherwise the
+  //group's first node was only tested with Process1Before2(newNode, first)
+  //and the search began after it ...
+  std::sort(m_IntersectNodes.begin(), m_IntersectNodes.end(),
+    IntersectNodeYGreater< cInt >);
+
+  typename IntersectList::size_type groupStart = 0;
+  while ( groupStart < m_IntersectNodes.size() )
   {
-    IntersectNode* iNode = m_IntersectNodes->next;
+    typename IntersectList::size_type groupEnd = groupStart + 1;
+    while ( groupEnd < m_IntersectNodes.size() &&
+      m_IntersectNodes[groupEnd].pt.Y == m_IntersectNodes[groupStart].pt.Y )
+        ++groupEnd;
+
+    if ( groupEnd - groupStart > 1 )
     {
-      IntersectEdges( m_IntersectNodes->edge1 ,
-        m_IntersectNodes->edge2 , m_IntersectNodes->pt, ipBoth );
-      SwapPositionsInAEL( m_IntersectNodes->edge1 , m_IntersectNodes->edge2 );
+      IntersectList &group = m_IntersectBuffer;
+      group.clear();
+      for (typename IntersectList::size_type i = groupStart; i < groupEnd; ++i)
+      {
+        IntersectNode &newNode = m_IntersectNodes[i];
+        typename IntersectList::size_type k = 0;
+        if ( !newNode.followsLargerY && !group.empty() )
+        {
+          if ( Process1Before2(newNode, group[0]) )
+          {
+            group.insert(group.begin(), newNode);
+            continue;
+          }
+          k = 1;
+        }
+        while ( k < group.size() && Process1Before2(group[k], newNode) ) ++k;
+        group.insert(group.begin() + k, newNode);
+      }
+      std::copy(group.begin(), group.end(),
+        m_IntersectNodes.begin() + groupStart);
     }
-    delete m_IntersectNodes;
-    m_IntersectNodes = iNode;
+    groupStart = groupEnd;
+  }
+}
+//------------------------------------------------------------------------------
+
+template <typename cInt>
+void ClipperT< cInt >::ProcessIntersectList()
+{
+  for (typename IntersectList::size_type i = 0;
+    i < m_IntersectNodes.size(); ++i)
+  {
+    IntersectEdges( m_IntersectNodes[i].edge1 ,
+      m_IntersectNodes[i].edge2 , m_IntersectNodes[i].pt, ipBoth );
+    SwapPositionsInAEL( m_IntersectNodes[i].edge1 , m_IntersectNodes[i].edge2 );
   }
+  m_IntersectNodes.clear();
 }
 //------------------------------------------------------------------------------
 
-void Clipper::DoMaxima(TEdge *e, long64 topY)
+template <typename cInt>
+void ClipperT< cInt >::DoMaxima(TEdge *e, cInt topY)
 {
   TEdge* eMaxPair = GetMaximaPair(e);
-  long64 X = e->xtop;
+  cInt X = e->xtop;
   TEdge* eNext = e->nextInAEL;
   while( eNext != eMaxPair )
   {
     if (!eNext) throw clipperException("DoMaxima error");
-    IntersectEdges( e, eNext, IntPoint(X, topY), ipBoth );
+    IntersectEdges( e, eNext, Point(X, topY), ipBoth );
     eNext = eNext->nextInAEL;
   }
   if( e->outIdx < 0 && eMaxPair->outIdx < 0 )
@@ -2143,13 +2465,14 @@ void Clipper::DoMaxima(TEdge *e, long64 topY)
   }
   else if( e->outIdx >= 0 && eMaxPair->outIdx >= 0 )
   {
-    IntersectEdges( e, eMaxPair, IntPoint(X, topY), ipNone );
+    IntersectEdges( e, eMaxPair, Point(X, topY), ipNone );
   }
   else throw clipperException("DoMaxima error");
 }
 //------------------------------------------------------------------------------
 
-void Clipper::ProcessEdgesAtTopOfScanbeam(const long64 topY)
+template <typename cInt>
+void ClipperT< cInt >::ProcessEdgesAtTopOfScanbeam(const cInt topY)
 {
   TEdge* e = m_ActiveEdges;
   while( e )
@@ -2171,16 +2494,17 @@ void Clipper::ProcessEdgesAtTopOfScanbeam(const long64 topY)
       {
         if (e->outIdx >= 0)
         {
-          AddPolyPt(e, IntPoint(e->xtop, e->ytop));
+          AddPolyPt(e, Point(e->xtop, e->ytop));
 
-          for (HorzJoinList::size_type i = 0; i < m_HorizJoins.size(); ++i)
+          for (typename HorzJoinList::size_type i = 0;
+            i < m_HorizJoins.size(); ++i)
           {
-            IntPoint pt, pt2;
+            Point pt, pt2;
             HorzJoinRec* hj = m_HorizJoins[i];
-            if (GetOverlapSegment(IntPoint(hj->edge->xbot, hj->edge->ybot),
-              IntPoint(hj->edge->xtop, hj->edge->ytop),
-              IntPoint(e->nextInLML->xbot, e->nextInLML->ybot),
-              IntPoint(e->nextInLML->xtop, e->nextInLML->ytop), pt, pt2))
+            if (GetOverlapSegment(Point(hj->edge->xbot, hj->edge->ybot),
+              Point(hj->edge->xtop, hj->edge->ytop),
+              Point(e->nextInLML->xbot, e->nextInLML->ybot),
+              Point(e->nextInLML->xtop, e->nextInLML->ytop), pt, pt2))
                 AddJoin(hj->edge, e->nextInLML, hj->savedIdx, e->outIdx);
           }
 
@@ -2207,28 +2531,28 @@ void Clipper::ProcessEdgesAtTopOfScanbeam(const long64 topY)
   {
     if( IsIntermediate( e, topY ) )
     {
-      if( e->outIdx >= 0 ) AddPolyPt(e, IntPoint(e->xtop,e->ytop));
+      if( e->outIdx >= 0 ) AddPolyPt(e, Point(e->xtop,e->ytop));
       UpdateEdgeIntoAEL(e);
 
       //if output polygons share an edge, they'll need joining later ...
       if (e->outIdx >= 0 && e->prevInAEL && e->prevInAEL->outIdx >= 0 &&
         e->prevInAEL->xcurr == e->xbot && e->prevInAEL->ycurr == e->ybot &&
-        SlopesEqual(IntPoint(e->xbot,e->ybot), IntPoint(e->xtop, e->ytop),
-          IntPoint(e->xbot,e->ybot),
-          IntPoint(e->prevInAEL->xtop, e->prevInAEL->ytop), m_UseFullRange))
+        SlopesEqual(Point(e->xbot,e->ybot), Point(e->xtop, e->ytop),
+          Point(e->xbot,e->ybot),
+          Point(e->prevInAEL->xtop, e->prevInAEL->ytop), m_UseFullRange))
       {
-        AddPolyPt(e->prevInAEL, IntPoint(e->xbot, e->ybot));
+        AddPolyPt(e->prevInAEL, Point(e->xbot, e->ybot));
         AddJoin(e, e->prevInAEL);
       }
       else if (e->outIdx >= 0 && e->nextInAEL && e->nextInAEL->outIdx >= 0 &&
         e->nextInAEL->ycurr > e->nextInAEL->ytop &&
         e->nextInAEL->ycurr < e->nextInAEL->ybot &&
         e->nextInAEL->xcurr == e->xbot && e->nextInAEL->ycurr == e->ybot &&
-        SlopesEqual(IntPoint(e->xbot,e->ybot), IntPoint(e->xtop, e->ytop),
-          IntPoint(e->xbot,e->ybot),
-          IntPoint(e->nextInAEL->xtop, e->nextInAEL->ytop), m_UseFullRange))
+        SlopesEqual(Point(e->xbot,e->ybot), Point(e->xtop, e->ytop),
+          Point(e->xbot,e->ybot),
+          Point(e->nextInAEL->xtop, e->nextInAEL->ytop), m_UseFullRange))
       {
-        AddPolyPt(e->nextInAEL, IntPoint(e->xbot, e->ybot));
+        AddPolyPt(e->nextInAEL, Point(e->xbot, e->ybot));
         AddJoin(e, e->nextInAEL);
       }
     }
@@ -2237,7 +2561,8 @@ void Clipper::ProcessEdgesAtTopOfScanbeam(const long64 topY)
 }
 //------------------------------------------------------------------------------
 
-PolyPt* Clipper::FixupOutPolygon(PolyPt *p)
+template <typename cInt>
+PolyPt< cInt >* ClipperT< cInt >::FixupOutPolygon(PolyPt *p)
 {
   //FixupOutPolygon() - removes duplicate points and simplifies consecutive
   //parallel edges by removing the middle vertex.
@@ -2257,10 +2582,8 @@ PolyPt* Clipper::FixupOutPolygon(PolyPt *p)
       lastOK = 0;
       pp->prev->next = pp->next;
       pp->next->prev = pp->prev;
-      PolyPt* tmp = pp;
       if (pp == result) result = pp->prev;
       pp = pp->prev;
-      delete tmp;
     }
     else if (pp == lastOK) break;
     else
@@ -2273,9 +2596,10 @@ PolyPt* Clipper::FixupOutPolygon(PolyPt *p)
 }
 //------------------------------------------------------------------------------
 
-void Clipper::BuildResult(Polygons &polypoly)
+template <typename cInt>
+void ClipperT< cInt >::FixupResult()
 {
-  for (PolyPtList::size_type i = 0; i < m_PolyPts.size(); ++i)
+  for (typename PolyPtList::size_type i = 0; i < m_PolyPts.size(); ++i)
     if (m_PolyPts[i])
     {
       m_PolyPts[i] = FixupOutPolygon(m_PolyPts[i]);
@@ -2285,6 +2609,13 @@ void Clipper::BuildResult(Polygons &polypoly)
         ReversePolyPtLinks(*p);
     }
   JoinCommonEdges();
+}
+//------------------------------------------------------------------------------
+
+template <typename cInt>
+void ClipperT< cInt >::BuildResult(Polygons &polypoly)
+{
+  FixupResult();
 
   int k = 0;
   polypoly.resize(m_PolyPts.size());
@@ -2295,7 +2626,7 @@ void Clipper::BuildResult(Polygons &polypoly)
       PolyPt* p = m_PolyPts[i];
 
       do {
-        pg->push_back(p->pt);
+        pg->push_back(IntPoint(p->pt.X, p->pt.Y));
         p = p->next;
       } while (p != m_PolyPts[i]);
       //make sure each polygon has at least 3 vertices ...
@@ -2306,11 +2637,13 @@ void Clipper::BuildResult(Polygons &polypoly)
 }
 //------------------------------------------------------------------------------
 
-void SwapIntersectNodes(IntersectNode &int1, IntersectNode &int2)
+template <typename cInt>
+void SwapIntersectNodes(IntersectNode< cInt > &int1,
+  IntersectNode< cInt > &int2)
 {
-  TEdge *e1 = int1.edge1;
-  TEdge *e2 = int1.edge2;
-  IntPoint p = int1.pt;
+  TEdge< cInt > *e1 = int1.edge1;
+  TEdge< cInt > *e2 = int1.edge2;
+  TIntPoint< cInt > p = int1.pt;
 
   int1.edge1 = int2.edge1;
   int1.edge2 = int2.edge2;
@@ -2322,14 +2655,16 @@ void SwapIntersectNodes(IntersectNode &int1, IntersectNode &int2)
 }
 //------------------------------------------------------------------------------
 
-bool Clipper::FixupIntersections()
+template <typename cInt>
+bool ClipperT< cInt >::FixupIntersections()
 {
-  if ( !m_IntersectNodes->next ) return true;
+  typename IntersectList::size_type count = m_IntersectNodes.size();
+  if ( count == 1 ) return true;
 
   CopyAELToSEL();
-  IntersectNode *int1 = m_IntersectNodes;
-  IntersectNode *int2 = m_IntersectNodes->next;
-  while (int2)
+  IntersectNode *int1 = &m_IntersectNodes[0];
+  typename IntersectList::size_type i = 0, j = 1;
+  while (j < count)
   {
     TEdge *e1 = int1->edge1;
     TEdge *e2;
@@ -2339,22 +2674,23 @@ bool Clipper::FixupIntersections()
     {
       //The current intersection is out of order, so try and swap it with
       //a subsequent intersection ...
-      while (int2)
+      while (j < count)
       {
-        if (int2->edge1->nextInSEL == int2->edge2 ||
-          int2->edge1->prevInSEL == int2->edge2) break;
-        else int2 = int2->next;
+        IntersectNode &int2 = m_IntersectNodes[j];
+        if (int2.edge1->nextInSEL == int2.edge2 ||
+          int2.edge1->prevInSEL == int2.edge2) break;
+        else ++j;
       }
-      if ( !int2 ) return false; //oops!!!
+      if ( j == count ) return false; //oops!!!
 
       //found an intersect node that can be swapped ...
-      SwapIntersectNodes(*int1, *int2);
+      SwapIntersectNodes(*int1, m_IntersectNodes[j]);
       e1 = int1->edge1;
       e2 = int1->edge2;
     }
     SwapPositionsInSEL(e1, e2);
-    int1 = int1->next;
-    int2 = int1->next;
+    int1 = &m_IntersectNodes[++i];
+    j = i + 1;
   }
 
   m_SortedEdges = 0;
@@ -2365,14 +2701,16 @@ bool Clipper::FixupIntersections()
 }
 //------------------------------------------------------------------------------
 
-bool E2InsertsBeforeE1(TEdge &e1, TEdge &e2)
+template <typename cInt>
+bool E2InsertsBeforeE1(TEdge< cInt > &e1, TEdge< cInt > &e2)
 {
   if (e2.xcurr == e1.xcurr) return e2.dx > e1.dx;
   else return e2.xcurr < e1.xcurr;
 }
 //------------------------------------------------------------------------------
 
-void Clipper::InsertEdgeIntoAEL(TEdge *edge)
+template <typename cInt>
+void ClipperT< cInt >::InsertEdgeIntoAEL(TEdge *edge)
 {
   edge->prevInAEL = 0;
   edge->nextInAEL = 0;
@@ -2398,7 +2736,8 @@ void Clipper::InsertEdgeIntoAEL(TEdge *edge)
 }
 //----------------------------------------------------------------------
 
-void Clipper::DoEdge1(TEdge *edge1, TEdge *edge2, const IntPoint &pt)
+template <typename cInt>
+void ClipperT< cInt >::DoEdge1(TEdge *edge1, TEdge *edge2, const Point &pt)
 {
   AddPolyPt(edge1, pt);
   SwapSides(*edge1, *edge2);
@@ -2406,7 +2745,8 @@ void Clipper::DoEdge1(TEdge *edge1, TEdge *edge2, const IntPoint &pt)
 }
 //----------------------------------------------------------------------
 
-void Clipper::DoEdge2(TEdge *edge1, TEdge *edge2, const IntPoint &pt)
+template <typename cInt>
+void ClipperT< cInt >::DoEdge2(TEdge *edge1, TEdge *edge2, const Point &pt)
 {
   AddPolyPt(edge2, pt);
   SwapSides(*edge1, *edge2);
@@ -2414,7 +2754,8 @@ void Clipper::DoEdge2(TEdge *edge1, TEdge *edge2, const IntPoint &pt)
 }
 //----------------------------------------------------------------------
 
-void Clipper::DoBothEdges(TEdge *edge1, TEdge *edge2, const IntPoint &pt)
+template <typename cInt>
+void ClipperT< cInt >::DoBothEdges(TEdge *edge1, TEdge *edge2, const Point &pt)
 {
   AddPolyPt(edge1, pt);
   AddPolyPt(edge2, pt);
@@ -2423,7 +2764,8 @@ void Clipper::DoBothEdges(TEdge *edge1, TEdge *edge2, const IntPoint &pt)
 }
 //----------------------------------------------------------------------
 
-bool Clipper::IsHole(TEdge *e)
+template <typename cInt>
+bool ClipperT< cInt >::IsHole(TEdge *e)
 {
   bool hole = false;
   TEdge *e2 = m_ActiveEdges;
@@ -2436,32 +2778,30 @@ bool Clipper::IsHole(TEdge *e)
 }
 //----------------------------------------------------------------------
 
-PolyPt* DeletePolyPt(PolyPt* pp)
+template <typename cInt>
+PolyPt< cInt >* DeletePolyPt(PolyPt< cInt >* pp)
 {
-  if (pp->next == pp)
-  {
-    delete pp;
-    return 0;
-  } else
+  if (pp->next == pp) return 0;
+  else
   {
-    PolyPt* result = pp->prev;
+    PolyPt< cInt >* result = pp->prev;
     pp->next->prev = result;
     result->next = pp->next;
-    delete pp;
     return result;
   }
 }
 //------------------------------------------------------------------------------
 
-void Clipper::JoinCommonEdges()
+template <typename cInt>
+void ClipperT< cInt >::JoinCommonEdges()
 {
-  for (JoinList::size_type i = 0; i < m_Joins.size(); i++)
+  for (typename JoinList::size_type i = 0; i < m_Joins.size(); i++)
   {
     JoinRec* j = m_Joins[i];
     PolyPt *pp1a = m_PolyPts[j->poly1Idx];
     PolyPt *pp2a = m_PolyPts[j->poly2Idx];
-    IntPoint pt1 = j->pt2a, pt2 = j->pt2b;
-    IntPoint pt3 = j->pt1a, pt4 = j->pt1b;
+    Point pt1 = j->pt2a, pt2 = j->pt2b;
+    Point pt3 = j->pt1a, pt4 = j->pt1b;
     if (!FindSegment(pp1a, pt1, pt2)) continue;
     if (j->poly1Idx == j->poly2Idx)
     {
@@ -2479,29 +2819,29 @@ void Clipper::JoinCommonEdges()
     //get p1 & p2 polypts - the overlap start & endpoints on poly1
     if (PointsEqual(pp1a->pt, pt1)) p1 = pp1a;
     else if (PointsEqual(prev->pt, pt1)) p1 = prev;
-    else p1 = InsertPolyPtBetween(pp1a, prev, pt1);
+    else p1 = InsertPolyPtBetween(m_ExecuteArena, pp1a, prev, pt1);
 
     if (PointsEqual(pp1a->pt, pt2)) p2 = pp1a;
     else if (PointsEqual(prev->pt, pt2)) p2 = prev;
     else if ((p1 == pp1a) || (p1 == prev))
-      p2 = InsertPolyPtBetween(pp1a, prev, pt2);
+      p2 = InsertPolyPtBetween(m_ExecuteArena, pp1a, prev, pt2);
     else if (Pt3IsBetweenPt1AndPt2(pp1a->pt, p1->pt, pt2))
-      p2 = InsertPolyPtBetween(pp1a, p1, pt2); else
-      p2 = InsertPolyPtBetween(p1, prev, pt2);
+      p2 = InsertPolyPtBetween(m_ExecuteArena, pp1a, p1, pt2); else
+      p2 = InsertPolyPtBetween(m_ExecuteArena, p1, prev, pt2);
 
     //get p3 & p4 polypts - the overlap start & endpoints on poly2
     prev = pp2a->prev;
     if (PointsEqual(pp2a->pt, pt1)) p3 = pp2a;
     else if (PointsEqual(prev->pt, pt1)) p3 = prev;
-    else p3 = InsertPolyPtBetween(pp2a, prev, pt1);
+    else p3 = InsertPolyPtBetween(m_ExecuteArena, pp2a, prev, pt1);
 
     if (PointsEqual(pp2a->pt, pt2)) p4 = pp2a;
     else if (PointsEqual(prev->pt, pt2)) p4 = prev;
     else if ((p3 == pp2a) || (p3 == prev))
-      p4 = InsertPolyPtBetween(pp2a, prev, pt2);
+      p4 = InsertPolyPtBetween(m_ExecuteArena, pp2a, prev, pt2);
     else if (Pt3IsBetweenPt1AndPt2(pp2a->pt, p3->pt, pt2))
-      p4 = InsertPolyPtBetween(pp2a, p3, pt2); else
-      p4 = InsertPolyPtBetween(p3, prev, pt2);
+      p4 = InsertPolyPtBetween(m_ExecuteArena, pp2a, p3, pt2); else
+      p4 = InsertPolyPtBetween(m_ExecuteArena, p3, prev, pt2);
 
     //p1.pt == p3.pt and p2.pt == p4.pt so join p1 to p3 and p2 to p4 ...
     if (p1->next == p2 && p3->prev == p4)
@@ -2539,7 +2879,7 @@ void Clipper::JoinCommonEdges()
         SetHoleState(p1, !p2->isHole);
 
       //now fixup any subsequent m_Joins that match this polygon
-      for (JoinList::size_type k = i+1; k < m_Joins.size(); k++)
+      for (typename JoinList::size_type k = i+1; k < m_Joins.size(); k++)
       {
         JoinRec* j2 = m_Joins[k];
         if (j2->poly1Idx == j->poly1Idx && PointIsVertex(j2->pt1a, p2))
@@ -2553,7 +2893,7 @@ void Clipper::JoinCommonEdges()
       m_PolyPts[j->poly2Idx] = 0;
 
       //now fixup any subsequent fJoins that match this polygon
-      for (JoinList::size_type k = i+1; k < m_Joins.size(); k++)
+      for (typename JoinList::size_type k = i+1; k < m_Joins.size(); k++)
       {
         JoinRec* j2 = m_Joins[k];
         if (j2->poly1Idx == j->poly2Idx) j2->poly1Idx = j->poly1Idx;
@@ -2711,6 +3051,15 @@ bool OffsetPolygons(const Polygons &in_pgs, Polygons &out_pgs, const float &delt
   }
 }
 //------------------------------------------------------------------------------
+// Instantiations for both coordinate types (see clipper.h) ...
+//------------------------------------------------------------------------------
+
+template class ClipperBaseT< long64 >;
+template class ClipperT< long64 >;
+template class PreparedPolygonT< long64 >;
+template class ClipperBaseT< int >;
+template class ClipperT< int >;
+template class PreparedPolygonT< int >;
 
 } //namespace clipper
 
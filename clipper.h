@@ -30,6 +30,7 @@
 #include <stdexcept>
 #include <cstring>
 #include <cstdlib>
+#include <new>
 
 namespace clipper {
 
@@ -40,15 +41,22 @@ enum PolyFillType { pftEvenOdd, pftNonZero };
 typedef signed long long long64;
 typedef unsigned long long ulong64;
 
-struct IntPoint {
-  long64 X;
-  long64 Y;
-  IntPoint(long64 x = 0, long64 y = 0): X(x), Y(y) {};
+//the internal structures and the clipper itself are templated on the type
+//used to store coordinates. Clipper works with long64 coordinates, Clipper32
+//stores them in 32bit integers which makes edges smaller and arithmetic
+//cheaper but only accepts coordinates in the range +/- Clipper32Range ...
+template <typename cInt> struct TIntPoint {
+  cInt X;
+  cInt Y;
+  TIntPoint(cInt x = 0, cInt y = 0): X(x), Y(y) {};
 };
 
+typedef TIntPoint< long64 > IntPoint;
 typedef std::vector< IntPoint > Polygon;
 typedef std::vector< Polygon > Polygons;
 
+const long64 Clipper32Range = 0x3FFFFFFF; //differences must fit in 32bits
+
 bool IsClockwise(const Polygon &poly, bool UseFullInt64Range = true);
 double Area(const Polygon &poly, bool UseFullInt64Range = true);
 bool OffsetPolygons(const Polygons &in_pgs, Polygons &out_pgs, const float &delta);
@@ -57,15 +65,15 @@ bool OffsetPolygons(const Polygons &in_pgs, Polygons &out_pgs, const float &delt
 enum EdgeSide { esLeft, esRight };
 enum IntersectProtects { ipNone = 0, ipLeft = 1, ipRight = 2, ipBoth = 3 };
 
-struct TEdge {
-  long64 xbot;
-  long64 ybot;
-  long64 xcurr;
-  long64 ycurr;
-  long64 xtop;
-  long64 ytop;
+template <typename cInt> struct TEdge {
+  cInt xbot;
+  cInt ybot;
+  cInt xcurr;
+  cInt ycurr;
+  cInt xtop;
+  cInt ytop;
   double dx;
-  long64 tmpX;
+  cInt tmpX;
   PolyType polyType;
   EdgeSide side;
   int windDelta; //1 or -1 depending on winding direction
@@ -81,68 +89,96 @@ struct TEdge {
   TEdge *prevInSEL;
 };
 
-struct IntersectNode {
-  TEdge          *edge1;
-  TEdge          *edge2;
-  IntPoint        pt;
-  IntersectNode  *next;
-};
-
-struct LocalMinima {
-  long64          Y;
-  TEdge        *leftBound;
-  TEdge        *rightBound;
-  LocalMinima  *next;
+template <typename cInt> struct IntersectNode {
+  TEdge< cInt >  *edge1;
+  TEdge< cInt >  *edge2;
+  TIntPoint< cInt > pt;
+  int             order;          //position in the order nodes were added
+  bool            followsLargerY; //a node with a larger Y was added first
 };
 
-struct Scanbeam {
-  long64       Y;
-  Scanbeam *next;
+template <typename cInt> struct LocalMinima {
+  cInt            Y;
+  TEdge< cInt >  *leftBound;
+  TEdge< cInt >  *rightBound;
+  LocalMinima    *next;
 };
 
-struct PolyPt {
-  IntPoint pt;
+template <typename cInt> struct PolyPt {
+  TIntPoint< cInt > pt;
   PolyPt  *next;
   PolyPt  *prev;
   bool     isHole;
 };
 
-struct JoinRec {
-  IntPoint  pt1a;
-  IntPoint  pt1b;
+template <typename cInt> struct JoinRec {
+  TIntPoint< cInt > pt1a;
+  TIntPoint< cInt > pt1b;
   int       poly1Idx;
-  IntPoint  pt2a;
-  IntPoint  pt2b;
+  TIntPoint< cInt > pt2a;
+  TIntPoint< cInt > pt2b;
   int       poly2Idx;
 };
 
-struct HorzJoinRec {
-  TEdge   *edge;
+template <typename cInt> struct HorzJoinRec {
+  TEdge< cInt > *edge;
   int       savedIdx;
 };
 
 struct IntRect { long64 left; long64 top; long64 right; long64 bottom; };
 
-typedef std::vector < PolyPt* > PolyPtList;
-typedef std::vector < TEdge* > EdgeList;
-typedef std::vector < JoinRec* > JoinList;
-typedef std::vector < HorzJoinRec* > HorzJoinList;
+//Arena hands out memory for the internal structures above from a few large
+//blocks. Nothing is freed individually, Reset() makes all the memory available
+//again (merging the blocks into one) so a Clipper that is cleared and reused
+//stops allocating once it has seen its largest input. Only trivially
+//destructible types may be allocated since destructors are never run.
+class Arena
+{
+public:
+  Arena();
+  ~Arena();
+  template <typename T> T* New() { return new (Allocate(sizeof(T))) T; }
+  template <typename T> T* NewArray(std::size_t count)
+  {
+    T* result = static_cast<T*>(Allocate(sizeof(T) * count));
+    for (std::size_t i = 0; i < count; ++i) new (result + i) T;
+    return result;
+  }
+  void Reset();
+private:
+  struct Block { char *data; std::size_t size; };
+  void* Allocate(std::size_t size);
+  std::vector< Block > m_blocks;
+  std::size_t       m_used;     //bytes used in the last block
+  std::size_t       m_total;    //size of all blocks
+  Arena(const Arena&);
+  Arena& operator=(const Arena&);
+};
+
+template <typename cInt> class PreparedPolygonT;
 
 //ClipperBase is the ancestor to the Clipper class. It should not be
 //instantiated directly. This class simply abstracts the conversion of sets of
 //polygon coordinates into edge objects that are stored in a LocalMinima list.
-class ClipperBase
+template <typename cInt> class ClipperBaseT
 {
 public:
-  ClipperBase();
-  virtual ~ClipperBase();
+  ClipperBaseT();
+  virtual ~ClipperBaseT();
   bool AddPolygon(const Polygon &pg, PolyType polyType);
   bool AddPolygons( const Polygons &ppg, PolyType polyType);
+  //adds a polygon whose edges were built in advance. The edges are shared,
+  //not copied, so pg must outlive this object's next Clear() and must not be
+  //added to two objects that execute at the same time ...
+  bool AddPrepared(PreparedPolygonT< cInt > &pg, PolyType polyType);
   virtual void Clear();
   IntRect GetBounds();
   bool UseFullCoordinateRange() {return m_UseFullRange;};
   void UseFullCoordinateRange(bool newVal);
 protected:
+  typedef clipper::TEdge< cInt > TEdge;
+  typedef clipper::LocalMinima< cInt > LocalMinima;
+  typedef TIntPoint< cInt > Point;
   void DisposeLocalMinimaList();
   TEdge* AddBoundsToLML(TEdge *e);
   void PopLocalMinima();
@@ -152,39 +188,71 @@ protected:
   LocalMinima      *m_MinimaList;
   bool              m_UseFullRange;
 private:
-  EdgeList          m_edges;
+  std::vector< TEdge* > m_edges;
+  std::vector< Point > m_PolyBuffer;
+  Arena             m_EdgeArena; //edges and local minima, reset by Clear()
 };
 
-class Clipper : public virtual ClipperBase
+template <typename cInt> class ClipperT : public virtual ClipperBaseT< cInt >
 {
 public:
-  Clipper();
-  ~Clipper();
+  ClipperT();
+  ~ClipperT();
   bool Execute(ClipType clipType,
     Polygons &solution,
     PolyFillType subjFillType = pftEvenOdd,
     PolyFillType clipFillType = pftEvenOdd);
+  //same as Execute() followed by summing Area(poly, false) of the solution,
+  //without copying the solution polygons out ...
+  bool ExecuteArea(ClipType clipType,
+    double &area,
+    PolyFillType subjFillType = pftEvenOdd,
+    PolyFillType clipFillType = pftEvenOdd);
 protected:
   void Reset();
 private:
+  typedef ClipperBaseT< cInt > Base;
+  typedef typename Base::TEdge TEdge;
+  typedef typename Base::LocalMinima LocalMinima;
+  typedef typename Base::Point Point;
+  typedef clipper::PolyPt< cInt > PolyPt;
+  typedef clipper::IntersectNode< cInt > IntersectNode;
+  typedef clipper::JoinRec< cInt > JoinRec;
+  typedef clipper::HorzJoinRec< cInt > HorzJoinRec;
+  typedef std::vector < PolyPt* > PolyPtList;
+  typedef std::vector < JoinRec* > JoinList;
+  typedef std::vector < HorzJoinRec* > HorzJoinList;
+  typedef std::vector < IntersectNode > IntersectList;
+  typedef std::vector < cInt > ScanbeamList;
+  using Base::m_CurrentLM;
+  using Base::m_MinimaList;
+  using Base::m_UseFullRange;
+  using Base::PopLocalMinima;
   PolyPtList        m_PolyPts;
   JoinList          m_Joins;
   HorzJoinList      m_HorizJoins;
   ClipType          m_ClipType;
-  Scanbeam         *m_Scanbeam;
+  ScanbeamList      m_Scanbeam; //max-heap, may hold duplicates
   TEdge           *m_ActiveEdges;
   TEdge           *m_SortedEdges;
-  IntersectNode    *m_IntersectNodes;
+  IntersectList     m_IntersectNodes;
+  IntersectList     m_IntersectBuffer;
+  cInt              m_IntersectMaxY;
   bool              m_ExecuteLocked;
   PolyFillType      m_ClipFillType;
   PolyFillType      m_SubjFillType;
+  Arena             m_ExecuteArena; //everything Execute() creates, reset after
+  bool Sweep(ClipType clipType,
+    PolyFillType subjFillType, PolyFillType clipFillType);
+  void DisposeExecuteData();
+  double ResultArea();
   void DisposeScanbeamList();
   void SetWindingCount(TEdge& edge);
   bool IsNonZeroFillType(const TEdge& edge) const;
   bool IsNonZeroAltFillType(const TEdge& edge) const;
-  void InsertScanbeam(const long64 Y);
-  long64 PopScanbeam();
-  void InsertLocalMinimaIntoAEL(const long64 botY);
+  void InsertScanbeam(const cInt Y);
+  cInt PopScanbeam();
+  void InsertLocalMinimaIntoAEL(const cInt botY);
   void InsertEdgeIntoAEL(TEdge *edge);
   void AddEdgeToSEL(TEdge *edge);
   void CopyAELToSEL();
@@ -193,26 +261,28 @@ private:
   void UpdateEdgeIntoAEL(TEdge *&e);
   void SwapPositionsInSEL(TEdge *edge1, TEdge *edge2);
   bool IsContributing(const TEdge& edge) const;
-  bool IsTopHorz(const long64 XPos);
+  bool IsTopHorz(const cInt XPos);
   void SwapPositionsInAEL(TEdge *edge1, TEdge *edge2);
-  void DoMaxima(TEdge *e, long64 topY);
+  void DoMaxima(TEdge *e, cInt topY);
   void ProcessHorizontals();
   void ProcessHorizontal(TEdge *horzEdge);
-  void AddLocalMaxPoly(TEdge *e1, TEdge *e2, const IntPoint &pt);
-  void AddLocalMinPoly(TEdge *e1, TEdge *e2, const IntPoint &pt);
+  void AddLocalMaxPoly(TEdge *e1, TEdge *e2, const Point &pt);
+  void AddLocalMinPoly(TEdge *e1, TEdge *e2, const Point &pt);
   void AppendPolygon(TEdge *e1, TEdge *e2);
-  void DoEdge1(TEdge *edge1, TEdge *edge2, const IntPoint &pt);
-  void DoEdge2(TEdge *edge1, TEdge *edge2, const IntPoint &pt);
-  void DoBothEdges(TEdge *edge1, TEdge *edge2, const IntPoint &pt);
+  void DoEdge1(TEdge *edge1, TEdge *edge2, const Point &pt);
+  void DoEdge2(TEdge *edge1, TEdge *edge2, const Point &pt);
+  void DoBothEdges(TEdge *edge1, TEdge *edge2, const Point &pt);
   void IntersectEdges(TEdge *e1, TEdge *e2,
-    const IntPoint &pt, IntersectProtects protects);
-  PolyPt* AddPolyPt(TEdge *e, const IntPoint &pt);
+    const Point &pt, IntersectProtects protects);
+  PolyPt* AddPolyPt(TEdge *e, const Point &pt);
   void DisposeAllPolyPts();
-  bool ProcessIntersections( const long64 topY);
-  void AddIntersectNode(TEdge *e1, TEdge *e2, const IntPoint &pt);
-  void BuildIntersectList(const long64 topY);
+  bool ProcessIntersections( const cInt topY);
+  void AddIntersectNode(TEdge *e1, TEdge *e2, const Point &pt);
+  void SortIntersectNodes();
+  void BuildIntersectList(const cInt topY);
   void ProcessIntersectList();
-  void ProcessEdgesAtTopOfScanbeam(const long64 topY);
+  void ProcessEdgesAtTopOfScanbeam(const cInt topY);
+  void FixupResult();
   void BuildResult(Polygons& polypoly);
   void DisposeIntersectNodes();
   bool FixupIntersections();
@@ -225,6 +295,30 @@ private:
   void JoinCommonEdges();
 };
 
+//PreparedPolygon converts a polygon into edges and local minima once so it
+//can be clipped against many other polygons (see ClipperBase::AddPrepared)
+//without being processed again each time ...
+template <typename cInt> class PreparedPolygonT : private ClipperBaseT< cInt >
+{
+public:
+  PreparedPolygonT();
+  bool Prepare(const Polygon &pg);
+  double Area() const {return m_Area;}; //absolute area
+  IntRect Bounds() const {return m_Bounds;};
+private:
+  friend class ClipperBaseT< cInt >;
+  double            m_Area;
+  IntRect           m_Bounds;
+  std::vector< int > m_WindDeltas; //Execute() changes them, see AddPrepared()
+};
+
+//the definitions are in clipper.cc which instantiates both coordinate types ...
+typedef ClipperBaseT< long64 > ClipperBase;
+typedef ClipperT< long64 > Clipper;
+typedef PreparedPolygonT< long64 > PreparedPolygon;
+typedef ClipperT< int > Clipper32;
+typedef PreparedPolygonT< int > PreparedPolygon32;
+
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 
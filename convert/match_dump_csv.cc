@@ -0,0 +1,40 @@
+// print a match dump (see match_dump.h) as csv, one row per scored pair of
+// regions, for loading into tools that don't read the binary layout
+
+#include <cstdio>
+#include <iostream>
+#include "../match_dump.h"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+  if ( argc < 2 )
+  {
+    cout << "Usage : ./" << argv[0] << " <match dump>" << endl;
+    return -1;
+  }
+
+  MatchDump dump;
+  if ( !dump.Open(argv[1]) )
+  {
+    cout << "Could not read match dump " << argv[1] << endl;
+    return -1;
+  }
+
+  // columns come straight out of the memory map
+  const boost::uint32_t* images = dump.ImageIds();
+  const boost::uint32_t* truths = dump.TruthIds();
+  const boost::uint32_t* computed = dump.ComputedIds();
+  const double* ious = dump.Ious();
+  const float* scores = dump.Scores();
+  const boost::uint32_t* labels = dump.LabelIds();
+
+  printf("image,truth,computed,iou,score,label\n");
+  for ( size_t i = 0; i < dump.Rows(); ++i )
+    printf("%s,%u,%u,%.9g,%.9g,%s\n",
+           dump.ImagePath(images[i]).c_str(), truths[i], computed[i],
+           ious[i], scores[i], dump.Label(labels[i]).c_str());
+
+  return 0;
+}
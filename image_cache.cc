@@ -0,0 +1,297 @@
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <sstream>
+#include <vector>
+#include <highgui.h>
+#include <boost/functional/hash.hpp>
+#include "image_cache.h"
+
+namespace fs = boost::filesystem;
+
+///////////////////////// LOCAL FUNCTIONS //////////////////////////////////////
+
+// key of an image in the cache
+std::string CacheKey( const fs::path& filename, int scale )
+{
+  std::ostringstream key;
+  key << filename.string() << '|' << scale;
+  return key.str();
+}
+
+// bytes of pixels held by an image
+size_t ImageBytes( const cv::Mat& image )
+{
+  return image.total() * image.elemSize();
+}
+
+// a stored file with the time it was last read, for ImageCache::Trim()
+struct StoredFile
+{
+  std::time_t     time;
+  boost::uint64_t size;
+  fs::path        path;
+};
+
+bool OlderFile( const StoredFile& lhs, const StoredFile& rhs )
+{
+  return lhs.time < rhs.time;
+}
+
+//////////////////////// GLOBAL FUNCTIONS //////////////////////////////////////
+
+cv::Mat DecodeImage( const fs::path& filename, int scale )
+{
+#if CV_MAJOR_VERSION >= 3
+  if ( scale == 2 )
+    return cv::imread(filename.string(), cv::IMREAD_REDUCED_COLOR_2);
+  if ( scale == 4 )
+    return cv::imread(filename.string(), cv::IMREAD_REDUCED_COLOR_4);
+  if ( scale == 8 )
+    return cv::imread(filename.string(), cv::IMREAD_REDUCED_COLOR_8);
+#endif
+  cv::Mat image = cv::imread(filename.string());
+  if ( scale <= 1 || image.empty() )
+    return image;
+
+  cv::Mat reduced;
+  cv::resize(image, reduced,
+             cv::Size(( image.cols + scale - 1 ) / scale,
+                      ( image.rows + scale - 1 ) / scale),
+             0, 0, cv::INTER_AREA);
+  return reduced;
+}
+
+ImageCache::ImageCache( size_t memory_budget, const fs::path& folder,
+  boost::uint64_t disk_budget ) :
+  memory_budget_(memory_budget), memory_used_(0), folder_(folder),
+  disk_budget_(disk_budget), disk_used_(0)
+{
+  boost::system::error_code error;
+  if ( !folder_.empty() && !fs::exists(folder_, error) &&
+       !fs::create_directories(folder_, error) )
+    folder_.clear();
+
+  // the store may be left over from earlier runs
+  TrimTo(disk_budget_);
+}
+
+cv::Mat ImageCache::Get( const fs::path& filename, int scale,
+  bool remember )
+{
+  const std::string key = CacheKey(filename, scale);
+
+  cv::Mat image;
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    std::map<std::string, EntryList::iterator>::iterator found =
+      index_.find(key);
+    if ( found != index_.end() )
+    {
+      entries_.splice(entries_.begin(), entries_, found->second);
+      image = found->second->second;
+    }
+  }
+
+  // cached pixels are never written so they can be copied without the lock
+  if ( !image.empty() )
+    return image.clone();
+
+  if ( !Load(filename, scale, image) )
+  {
+    image = DecodeImage(filename, scale);
+    Store(filename, scale, image);
+  }
+
+  if ( image.empty() || memory_budget_ == 0 || !remember )
+    return image;
+  Insert(key, image);
+  return image.clone();
+}
+
+void ImageCache::Insert( const std::string& key, const cv::Mat& image )
+{
+  const size_t bytes = ImageBytes(image);
+  if ( bytes > memory_budget_ )
+    return;
+
+  boost::unique_lock<boost::mutex> lock(mutex_);
+
+  // another thread may have read the same image meanwhile
+  if ( index_.count(key) )
+    return;
+
+  entries_.push_front(std::make_pair(key, image));
+  index_[key] = entries_.begin();
+  memory_used_ += bytes;
+
+  while ( memory_used_ > memory_budget_ )
+  {
+    memory_used_ -= ImageBytes(entries_.back().second);
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+}
+
+fs::path ImageCache::StorePath( const fs::path& filename, int scale ) const
+{
+  std::ostringstream name;
+  name << std::hex << boost::hash<std::string>()(CacheKey(filename, scale))
+       << ".raw";
+  return folder_ / name.str();
+}
+
+bool ImageCache::Load( const fs::path& filename, int scale,
+  cv::Mat& image ) const
+{
+  if ( folder_.empty() )
+    return false;
+
+  boost::system::error_code error;
+  boost::uint64_t source_size = fs::file_size(filename, error);
+  if ( error )
+    return false;
+  std::time_t source_time = fs::last_write_time(filename, error);
+  if ( error )
+    return false;
+
+  const fs::path store = StorePath(filename, scale);
+  FILE* file = fopen(store.string().c_str(), "rb");
+  if ( !file )
+    return false;
+
+  // the stored path guards against two images with the same hash
+  const std::string path = filename.string();
+  ImageCacheHeader header;
+  std::vector<char> stored_path(path.size());
+  bool valid =
+    fread(&header, sizeof(header), 1, file) == 1 &&
+    memcmp(header.magic, IMAGE_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+    header.source_size == source_size &&
+    header.source_time == source_time &&
+    header.scale == scale &&
+    header.path_length == path.size() &&
+    header.rows > 0 && header.cols > 0 &&
+    ( path.empty() ||
+      fread(&stored_path[0], path.size(), 1, file) == 1 ) &&
+    std::equal(stored_path.begin(), stored_path.end(), path.begin());
+
+  if ( valid )
+  {
+    image.create(header.rows, header.cols, header.type);
+    valid = fread(image.data, ImageBytes(image), 1, file) == 1;
+  }
+  fclose(file);
+
+  if ( !valid )
+  {
+    image.release();
+    return false;
+  }
+
+  // mark the file as recently used for Trim()
+  fs::last_write_time(store, std::time(0), error);
+  return true;
+}
+
+void ImageCache::Store( const fs::path& filename, int scale,
+  const cv::Mat& image )
+{
+  if ( folder_.empty() || image.empty() )
+    return;
+
+  boost::system::error_code error;
+  ImageCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, IMAGE_CACHE_MAGIC, sizeof(header.magic));
+  header.source_size = fs::file_size(filename, error);
+  if ( error )
+    return;
+  header.source_time = fs::last_write_time(filename, error);
+  if ( error )
+    return;
+  header.scale = scale;
+  header.rows = image.rows;
+  header.cols = image.cols;
+  header.type = image.type();
+
+  const std::string path = filename.string();
+  header.path_length = path.size();
+
+  const boost::uint64_t bytes =
+    sizeof(header) + path.size() + ImageBytes(image);
+  if ( bytes > disk_budget_ )
+    return;
+
+  // make room before writing.  Trimming well below the budget keeps the
+  // folder scans rare when every image of a large set is stored.
+  {
+    boost::unique_lock<boost::mutex> lock(disk_mutex_);
+    if ( disk_used_ + bytes > disk_budget_ )
+      TrimTo(std::min(disk_budget_ - bytes, disk_budget_ / 4 * 3));
+    if ( disk_used_ + bytes > disk_budget_ )
+      return;
+    disk_used_ += bytes;
+  }
+
+  cv::Mat pixels = image.isContinuous() ? image : image.clone();
+
+  // written under a name of its own and renamed so readers never see a
+  // partial file
+  const fs::path store = StorePath(filename, scale);
+  std::ostringstream temporary;
+  temporary << store.string() << '.' << boost::this_thread::get_id();
+  FILE* file = fopen(temporary.str().c_str(), "wb");
+  bool written = file &&
+    fwrite(&header, sizeof(header), 1, file) == 1 &&
+    fwrite(path.data(), 1, path.size(), file) == path.size() &&
+    fwrite(pixels.data, ImageBytes(pixels), 1, file) == 1;
+  if ( file )
+    written = ( fclose(file) == 0 ) && written;
+
+  if ( written )
+    fs::rename(temporary.str(), store, error);
+  if ( !written || error )
+  {
+    fs::remove(temporary.str(), error);
+    boost::unique_lock<boost::mutex> lock(disk_mutex_);
+    disk_used_ -= std::min(disk_used_, bytes);
+  }
+}
+
+void ImageCache::Trim()
+{
+  boost::unique_lock<boost::mutex> lock(disk_mutex_);
+  TrimTo(disk_budget_);
+}
+
+void ImageCache::TrimTo( boost::uint64_t budget )
+{
+  if ( folder_.empty() )
+    return;
+
+  boost::system::error_code error;
+  std::vector<StoredFile> files;
+  boost::uint64_t total = 0;
+  for ( fs::directory_iterator it(folder_, error), end; !error && it != end;
+        it.increment(error) )
+  {
+    if ( it->path().extension() != ".raw" )
+      continue;
+    StoredFile file;
+    file.path = it->path();
+    file.size = fs::file_size(file.path, error);
+    file.time = fs::last_write_time(file.path, error);
+    if ( error )
+      return;
+    files.push_back(file);
+    total += file.size;
+  }
+
+  std::sort(files.begin(), files.end(), OlderFile);
+  for ( size_t i = 0; i < files.size() && total > budget; ++i )
+    if ( fs::remove(files[i].path, error) )
+      total -= files[i].size;
+  disk_used_ = total;
+}
@@ -0,0 +1,113 @@
+//
+// Description : Cache of decoded images for the drawing stages, so images
+//               that are drawn again (DrawResults() and SaveGallery() in one
+//               run, or repeated runs while tuning settings) skip the jpeg
+//               decoder.
+//
+// Images are looked up in an in-process LRU first, then in an on-disk store
+// of raw decoded pixels, and only then decoded from the original file.  Each
+// stored file is
+//
+//   header     ImageCacheHeader (magic "ATIMGC01")
+//   path       path_length bytes of the original image path
+//   pixels     rows * cols * elem_size bytes, row major
+//
+// An entry is only used if the size and modification time of the original
+// still match, so edited images are decoded again.  Reading an entry touches
+// its modification time.  The bytes in the store are counted as files are
+// written, once a new file would take the store over its budget the least
+// recently used files are removed down to three quarters of it.  Files that
+// still don't fit are not stored.
+//
+
+#ifndef ANALYSIS_IMAGE_CACHE
+#define ANALYSIS_IMAGE_CACHE
+
+#include <list>
+#include <map>
+#include <string>
+#include <cv.h>
+#include <boost/cstdint.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+#include <boost/utility.hpp>
+
+#define BOOST_FILESYSTEM_VERSION 3
+#define BOOST_FILESYSTEM_NO_DEPRECATED
+
+const char IMAGE_CACHE_MAGIC[8] = { 'A','T','I','M','G','C','0','1' };
+
+struct ImageCacheHeader
+{
+  char            magic[8];
+  boost::uint64_t source_size;    // bytes of the original image
+  boost::int64_t  source_time;    // modification time of the original
+  boost::int32_t  scale;          // reduction the image was decoded at
+  boost::int32_t  rows;
+  boost::int32_t  cols;
+  boost::int32_t  type;           // OpenCV type of the pixels
+  boost::uint32_t path_length;
+  boost::uint32_t reserved;
+};
+
+/**ImageCache******************************************************************\
+|   Description: Decoded images shared by every drawing thread.  Get() may be  |
+|                called from any thread, decoding and disk access happen       |
+|                outside the lock.                                             |
+|   Input:                                                                     |
+|     memory_budget: bytes of pixels kept in memory (0 for none)               |
+|     folder: on-disk store (empty for none)                                   |
+|     disk_budget: bytes the store is kept within                              |
+\******************************************************************************/
+class ImageCache : boost::noncopyable
+{
+  public:
+    ImageCache( size_t memory_budget, const boost::filesystem::path& folder,
+      boost::uint64_t disk_budget );
+
+    // image reduced by scale (see DecodeImage()), empty if it can't be read.
+    // The pixels are the caller's own and may be drawn on.  Images that
+    // won't be read again are not added to memory (remember false), a scan
+    // over more images than fit would only evict every image before reuse.
+    cv::Mat Get( const boost::filesystem::path& filename, int scale,
+      bool remember = true );
+
+    // removes the least recently read files until the store fits its budget,
+    // e.g. after other processes wrote to the same folder
+    void Trim();
+
+  private:
+    typedef std::list< std::pair<std::string, cv::Mat> > EntryList;
+
+    bool Load( const boost::filesystem::path& filename, int scale,
+      cv::Mat& image ) const;
+    void Store( const boost::filesystem::path& filename, int scale,
+      const cv::Mat& image );
+    void TrimTo( boost::uint64_t budget );
+    boost::filesystem::path StorePath( const boost::filesystem::path& filename,
+      int scale ) const;
+    void Insert( const std::string& key, const cv::Mat& image );
+
+    size_t                                    memory_budget_;
+    size_t                                    memory_used_;
+    boost::filesystem::path                   folder_;
+    boost::uint64_t                           disk_budget_;
+    boost::uint64_t                           disk_used_;  // bytes stored
+    EntryList                                 entries_;   // most recent first
+    std::map<std::string, EntryList::iterator> index_;
+    boost::mutex                              mutex_;
+    boost::mutex                              disk_mutex_; // guards disk_used_
+};
+
+/**DecodeImage*****************************************************************\
+|   Description: Read an image reduced by scale.  The jpeg decoder can skip    |
+|                the detail of the reduced sizes it supports (2, 4 and 8 with  |
+|                OpenCV 3 and up), other sizes are decoded in full and shrunk. |
+|   Input:                                                                     |
+|     filename: image to read                                                  |
+|     scale: reduction factor, 1 for full size                                 |
+|   Output: decoded image, empty if it can't be read                           |
+\******************************************************************************/
+cv::Mat DecodeImage( const boost::filesystem::path& filename, int scale );
+
+#endif // ANALYSIS_IMAGE_CACHE
@@ -8,6 +8,28 @@
 #define BOOST_FILESYSTEM_VERSION 3
 #define BOOST_FILESYSTEM_NO_DEPRECATED
 
+// outline of a region that is not a plain rectangle, the matching entry in
+// ImageRegionList::regions always holds the bounding box of the shape
+struct RegionShape
+{
+  typedef enum {
+    RECT    = 0,
+    POLYGON = 1,
+    ELLIPSE = 2,
+    MASK    = 3
+  } ShapeType;
+
+  RegionShape() : type(RECT) {}
+
+  ShapeType               type;
+  std::vector<cv::Point>  points;   // vertices of a POLYGON
+  cv::RotatedRect         ellipse;  // center, full axes and angle of an
+                                    // ELLIPSE (equal axes for a circle)
+  cv::Size                mask_size;  // image size covered by a MASK
+  std::vector<unsigned int> counts;   // column-major run lengths of a MASK,
+                                      // starting with background
+};
+
 struct ImageRegionList
 {
   // holds the file path to the image being processed
@@ -17,6 +39,13 @@ struct ImageRegionList
   std::vector<cv::Rect>     regions;
   std::vector<std::string>  labels;
   std::vector<float>        scores;
+
+  // shape of each region (regions holds the bounding box of non-rectangles)
+  std::vector<RegionShape>  shapes;
+
+  // size bucket of each region by bounding box area (-1 if it is below the
+  // first bucket), assigned when the regions are loaded
+  std::vector<int>          size_buckets;
 };
 
 #endif // ANALYSIS_IMAGE_REGION_LIST
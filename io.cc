@@ -1,9 +1,395 @@
 
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
 #include "io.h"
+#include "analysis_tools.h"
 
 namespace fs = boost::filesystem;
 
+///////////////////////// LOCAL FUNCTIONS //////////////////////////////////////
+
+// most polygon points ReadRegion() accepts, a larger count is taken as a
+// corrupt line rather than allocated
+const long MAX_POLYGON_POINTS = 1L << 20;
+
+/******************************************************************************\
+|   Decodes the compressed COCO string form of run lengths.  Each count is     |
+|   stored 5 bits per character (offset by '0') with the sixth bit set while   |
+|   more characters follow, counts after the second are stored as the          |
+|   difference from the count two places back.  Returns false on a malformed   |
+|   string.                                                                    |
+\******************************************************************************/
+bool DecodeRLE( const std::string& text, std::vector<unsigned int>& counts )
+{
+  counts.clear();
+  size_t p = 0;
+  while ( p < text.size() )
+  {
+    long value = 0;
+    int shift = 0;
+    bool more = true;
+    while ( more )
+    {
+      if ( p >= text.size() || shift > 30 )
+        return false;
+      long c = text[p++] - 48;
+      if ( c < 0 || c > 63 )
+        return false;
+      value |= (c & 0x1f) << shift;
+      shift += 5;
+      more = ( c & 0x20 ) != 0;
+      if ( !more && ( c & 0x10 ) )
+        value -= 1L << shift;  // sign extend
+    }
+    if ( counts.size() > 2 )
+      value += counts[counts.size() - 2];
+    if ( value < 0 )
+      return false;
+    counts.push_back(static_cast<unsigned int>(value));
+  }
+  return true;
+}
+
+/******************************************************************************\
+|   Reads the geometry of one region.  Rectangles are stored as                |
+|   <x> <y> <width> <height> (or <ULx> <ULy> <LRx> <LRy> if corners is true)   |
+|   other shapes start with a keyword                                          |
+|     poly <#points> <x1> <y1> ... <xn> <yn>                                   |
+|     rbox <center x> <center y> <width> <height> <angle (degrees)>            |
+|     circle <center x> <center y> <radius>                                    |
+|     ellipse <center x> <center y> <semi-axis x> <semi-axis y> <angle>        |
+|     mask <image height> <image width> <COCO compressed run lengths>          |
+|   rotated boxes are converted to four point polygons.  Ellipse angles are    |
+|   in degrees clockwise like rotated boxes.  Returns false for an unknown     |
+|   keyword, a truncated shape or a polygon with fewer than 3 (or an absurd    |
+|   number of) points, the stream is then failed since the rest of the line   |
+|   can't be parsed.  Also returns false for a mask whose runs are malformed   |
+|   or don't cover the whole image, the stream is left at the next region.    |
+\******************************************************************************/
+bool ReadRegion( std::istream& sin, bool corners, cv::Rect& roi,
+  RegionShape& shape )
+{
+  shape = RegionShape();
+
+  // plain rectangle, no keyword
+  sin >> std::ws;
+  if ( !isalpha(sin.peek()) )
+  {
+    sin >> roi.x >> roi.y >> roi.width >> roi.height;
+    if ( corners )
+    {
+      roi.width -= roi.x;
+      roi.height -= roi.y;
+    }
+    return true;
+  }
+
+  std::string keyword;
+  sin >> keyword;
+
+  if ( keyword == "mask" )
+  {
+    std::string text;
+    shape.type = RegionShape::MASK;
+    sin >> shape.mask_size.height >> shape.mask_size.width >> text;
+    if ( !sin || shape.mask_size.height <= 0 || shape.mask_size.width <= 0 ||
+         !DecodeRLE(text, shape.counts) || shape.counts.empty() )
+      return false;
+
+    // the runs have to cover the whole image
+    double total = 0.0;
+    for ( size_t i = 0; i < shape.counts.size(); ++i )
+      total += shape.counts[i];
+    if ( total != static_cast<double>(shape.mask_size.height) *
+                  shape.mask_size.width )
+      return false;
+
+    analysis_tools::Rect box = analysis_tools::boundingBox(
+      analysis_tools::RLE(shape.mask_size.height, shape.mask_size.width,
+                          &shape.counts[0], shape.counts.size()));
+    roi = cv::Rect(box.x, box.y, box.width, box.height);
+    return true;
+  }
+
+  if ( keyword == "circle" || keyword == "ellipse" )
+  {
+    float center_x, center_y, axis_x, axis_y, angle = 0.0f;
+    sin >> center_x >> center_y >> axis_x;
+    if ( keyword == "ellipse" )
+      sin >> axis_y >> angle;
+    else
+      axis_y = axis_x;
+    if ( !sin )
+      return false;
+
+    shape.type = RegionShape::ELLIPSE;
+    shape.ellipse = cv::RotatedRect(cv::Point2f(center_x, center_y),
+      cv::Size2f(2.0f * axis_x, 2.0f * axis_y), angle);
+
+    // smallest integer rectangle holding the rotated ellipse
+    const double c = std::cos(angle * M_PI / 180.0);
+    const double s = std::sin(angle * M_PI / 180.0);
+    const double half_width = std::sqrt(axis_x * axis_x * c * c +
+                                        axis_y * axis_y * s * s);
+    const double half_height = std::sqrt(axis_x * axis_x * s * s +
+                                         axis_y * axis_y * c * c);
+    int left   = static_cast<int>(floor(center_x - half_width));
+    int top    = static_cast<int>(floor(center_y - half_height));
+    int right  = static_cast<int>(ceil(center_x + half_width));
+    int bottom = static_cast<int>(ceil(center_y + half_height));
+    roi = cv::Rect(left, top, right - left, bottom - top);
+    return true;
+  }
+
+  if ( keyword != "rbox" && keyword != "poly" )
+  {
+    sin.setstate(std::ios::failbit);
+    return false;
+  }
+
+  shape.type = RegionShape::POLYGON;
+  if ( keyword == "rbox" )
+  {
+    double center_x, center_y, width, height, angle;
+    sin >> center_x >> center_y >> width >> height >> angle;
+    if ( !sin )
+      return false;
+
+    // rotate the corners about the center (clockwise, y axis points down)
+    const double c = std::cos(angle * M_PI / 180.0);
+    const double s = std::sin(angle * M_PI / 180.0);
+    const double corner_x[4] = { -0.5,  0.5, 0.5, -0.5 };
+    const double corner_y[4] = { -0.5, -0.5, 0.5,  0.5 };
+    for ( int i = 0; i < 4; ++i )
+    {
+      double dx = corner_x[i] * width, dy = corner_y[i] * height;
+      shape.points.push_back(cv::Point(
+        static_cast<int>(floor(center_x + dx * c - dy * s + 0.5)),
+        static_cast<int>(floor(center_y + dx * s + dy * c + 0.5))));
+    }
+  }
+  else
+  {
+    long point_count = 0;
+    sin >> point_count;
+    if ( !sin || point_count < 3 || point_count > MAX_POLYGON_POINTS )
+    {
+      sin.setstate(std::ios::failbit);
+      return false;
+    }
+    shape.points.resize(point_count);
+    for ( long i = 0; i < point_count; ++i )
+      sin >> shape.points[i].x >> shape.points[i].y;
+    if ( !sin )
+      return false;
+  }
+
+  // bounding box of the outline
+  int left = shape.points[0].x, right = shape.points[0].x;
+  int top = shape.points[0].y, bottom = shape.points[0].y;
+  for ( size_t i = 1; i < shape.points.size(); ++i )
+  {
+    left   = std::min(left,   shape.points[i].x);
+    right  = std::max(right,  shape.points[i].x);
+    top    = std::min(top,    shape.points[i].y);
+    bottom = std::max(bottom, shape.points[i].y);
+  }
+  roi = cv::Rect(left, top, right - left, bottom - top);
+  return true;
+}
+
+// reports a region that could not be read
+void RegionError( const fs::path& file_path, size_t line_number,
+  size_t region )
+{
+  std::cout << "Error: Skipping malformed region " << region + 1
+            << " on line " << line_number << " of " << file_path
+            << std::endl;
+}
+
+/******************************************************************************\
+|   Encodes run lengths in the compressed COCO string form read by             |
+|   DecodeRLE().                                                               |
+\******************************************************************************/
+void EncodeRLE( const std::vector<unsigned int>& counts, BufferedWriter& out )
+{
+  for ( size_t i = 0; i < counts.size(); ++i )
+  {
+    long value = counts[i];
+    if ( i > 2 )
+      value -= counts[i - 2];
+
+    bool more = true;
+    while ( more )
+    {
+      long c = value & 0x1f;
+      value >>= 5;
+      more = ( c & 0x10 ) ? value != -1 : value != 0;
+      if ( more )
+        c |= 0x20;
+      out.Write(static_cast<char>(c + 48));
+    }
+  }
+}
+
+// size bucket of a region, bucket i holds bounding box areas in
+// [size_buckets[i], size_buckets[i + 1])
+int SizeBucket( const cv::Rect& roi, const std::vector<double>& size_buckets )
+{
+  return std::upper_bound(size_buckets.begin(), size_buckets.end(),
+    static_cast<double>(roi.area())) - size_buckets.begin() - 1;
+}
+
+//////////////////////// GLOBAL FUNCTIONS //////////////////////////////////////
+
+BufferedWriter::BufferedWriter( size_t buffer_size ) :
+  file_(0), buffer_(new char[buffer_size]), size_(buffer_size), used_(0),
+  failed_(false)
+{}
+
+BufferedWriter::~BufferedWriter()
+{
+  Close();
+}
+
+bool BufferedWriter::Open( const fs::path& filename, bool binary )
+{
+  Close();
+  file_ = fopen(filename.string().c_str(), binary ? "wb" : "w");
+  failed_ = ( file_ == 0 );
+  return !failed_;
+}
+
+bool BufferedWriter::Close()
+{
+  if ( file_ )
+  {
+    Flush();
+    if ( fclose(file_) != 0 )
+      failed_ = true;
+    file_ = 0;
+  }
+  return !failed_;
+}
+
+void BufferedWriter::Flush()
+{
+  if ( file_ && used_ > 0 && fwrite(buffer_.get(), 1, used_, file_) != used_ )
+    failed_ = true;
+  used_ = 0;
+}
+
+BufferedWriter& BufferedWriter::Write( const char* text, size_t length )
+{
+  // text longer than the buffer goes straight to the file
+  Reserve(length);
+  if ( length > size_ )
+  {
+    if ( file_ && fwrite(text, 1, length, file_) != length )
+      failed_ = true;
+    return *this;
+  }
+  std::copy(text, text + length, buffer_.get() + used_);
+  used_ += length;
+  return *this;
+}
+
+BufferedWriter& BufferedWriter::Write( const char* text )
+{
+  return Write(text, strlen(text));
+}
+
+BufferedWriter& BufferedWriter::Write( const std::string& text )
+{
+  return Write(text.data(), text.size());
+}
+
+BufferedWriter& BufferedWriter::Write( char c )
+{
+  Reserve(1);
+  buffer_[used_++] = c;
+  return *this;
+}
+
+BufferedWriter& BufferedWriter::Write( long value )
+{
+  Reserve(32);
+  used_ += snprintf(buffer_.get() + used_, size_ - used_, "%ld", value);
+  return *this;
+}
+
+BufferedWriter& BufferedWriter::Write( float value, int precision )
+{
+  Reserve(64);
+  char* text = buffer_.get() + used_;
+  int digits = precision > 0 ? precision : 6;
+  int length = snprintf(text, size_ - used_, "%.*g", digits, value);
+  while ( precision <= 0 && digits < 9 && strtof(text, 0) != value )
+    length = snprintf(text, size_ - used_, "%.*g", ++digits, value);
+  used_ += length;
+  return *this;
+}
+
+BufferedWriter& BufferedWriter::Write( double value, int precision )
+{
+  Reserve(64);
+  char* text = buffer_.get() + used_;
+  int digits = precision > 0 ? precision : 15;
+  int length = snprintf(text, size_ - used_, "%.*g", digits, value);
+  while ( precision <= 0 && digits < 17 && strtod(text, 0) != value )
+    length = snprintf(text, size_ - used_, "%.*g", ++digits, value);
+  used_ += length;
+  return *this;
+}
+
+void WriteRegion( BufferedWriter& out, const cv::Rect& roi,
+  const RegionShape& shape, bool corners )
+{
+  switch ( shape.type )
+  {
+    case RegionShape::POLYGON:
+      out.Write("poly ").Write(static_cast<long>(shape.points.size()));
+      for ( size_t i = 0; i < shape.points.size(); ++i )
+        out.Write(' ').Write(static_cast<long>(shape.points[i].x))
+           .Write(' ').Write(static_cast<long>(shape.points[i].y));
+      break;
+
+    case RegionShape::ELLIPSE:
+    {
+      const cv::RotatedRect& e = shape.ellipse;
+      if ( e.size.width == e.size.height )
+        out.Write("circle ").Write(e.center.x).Write(' ').Write(e.center.y)
+           .Write(' ').Write(0.5f * e.size.width);
+      else
+        out.Write("ellipse ").Write(e.center.x).Write(' ').Write(e.center.y)
+           .Write(' ').Write(0.5f * e.size.width)
+           .Write(' ').Write(0.5f * e.size.height)
+           .Write(' ').Write(e.angle);
+      break;
+    }
+
+    case RegionShape::MASK:
+      out.Write("mask ").Write(static_cast<long>(shape.mask_size.height))
+         .Write(' ').Write(static_cast<long>(shape.mask_size.width))
+         .Write(' ');
+      EncodeRLE(shape.counts, out);
+      break;
+
+    default:
+      out.Write(static_cast<long>(roi.x)).Write(' ')
+         .Write(static_cast<long>(roi.y)).Write(' ')
+         .Write(static_cast<long>(corners ? roi.x + roi.width : roi.width))
+         .Write(' ')
+         .Write(static_cast<long>(corners ? roi.y + roi.height : roi.height));
+      break;
+  }
+}
+
 bool LoadComputedROI( const fs::path& file_path, double score_threshold,
+  const std::vector<double>& size_buckets,
   std::vector<ImageRegionList>& computed_regions )
 {
   // open file
@@ -22,11 +408,13 @@ bool LoadComputedROI( const fs::path& file_path, double score_threshold,
     size_t region_count;
 
     size_t index = computed_regions.size();
+    size_t line_number = 1;
     getline(fin, line);
     while ( fin.good() )
     {
       // line should have following format
       // <image> <#roi> : <label> <score> <ULx> <ULy> <LRx> <LRy> : <label> ...
+      // or any of the shapes accepted by ReadRegion() in place of the corners
       
       // load string stream to read from
       std::istringstream sin(line);
@@ -46,31 +434,34 @@ bool LoadComputedROI( const fs::path& file_path, double score_threshold,
       computed_regions[index].image_path = image_path;
 
       // read every region
-      cv::Point upper_left, lower_right;
       for ( size_t i = 0; i < region_count; ++i )
       {
 
 // HACKED SHOULDNT BE USED ///        
         string label;
         double score;
+        cv::Rect roi;
+        RegionShape shape;
 
-        sin >> garbage >> label >> score 
-            >> upper_left.x  >> upper_left.y
-            >> lower_right.x >> lower_right.y;
+        sin >> garbage >> label >> score;
+        if ( !ReadRegion(sin, true, roi, shape) )
+        {
+          // after an unknown keyword the rest of the line can't be read
+          RegionError(file_path, line_number, i);
+          if ( !sin )
+            break;
+          continue;
+        }
 
         // only read if score greater than threshold
         if ( score > score_threshold )
         {
           computed_regions[index].labels.push_back(label);
           computed_regions[index].scores.push_back(score);
-
-          cv::Rect roi;
-          roi.x = upper_left.x;
-          roi.y = upper_left.y;
-          roi.width = lower_right.x - upper_left.x;
-          roi.height = lower_right.y - upper_left.y;
-
           computed_regions[index].regions.push_back(roi);
+          computed_regions[index].shapes.push_back(shape);
+          computed_regions[index].size_buckets.push_back(
+            SizeBucket(roi, size_buckets));
         }
 
 /////////////////////////////////
@@ -92,6 +483,7 @@ bool LoadComputedROI( const fs::path& file_path, double score_threshold,
       }
 
       ++index;
+      ++line_number;
       getline(fin, line);
     }
   }
@@ -103,6 +495,7 @@ bool LoadComputedROI( const fs::path& file_path, double score_threshold,
 }
 
 bool LoadTrueROI( const fs::path& file_path,
+  const std::vector<double>& size_buckets,
   std::vector<ImageRegionList>& true_regions )
 {
   // open file
@@ -121,11 +514,13 @@ bool LoadTrueROI( const fs::path& file_path,
     size_t region_count;
 
     size_t index = true_regions.size();
+    size_t line_number = 1;
     getline(fin, line);
     while ( fin.good() )
     {
       // line should have following format
       // <image> <#roi> : <label> <ULx> <ULy> <width> <height> : <label> ...
+      // or any of the shapes accepted by ReadRegion() in place of the rectangle
       
       // load string stream to read from
       std::istringstream sin(line);
@@ -135,23 +530,35 @@ bool LoadTrueROI( const fs::path& file_path,
       // increase size of vector
       true_regions.push_back(ImageRegionList());
 
-      // initialize arrays in the ImageRegionList
-      true_regions[index].regions.resize(region_count);
-      true_regions[index].labels.resize(region_count);
-      true_regions[index].scores.resize(0);
-
       // implicit convertion from string to fs::path
       true_regions[index].image_path = image_path;
 
-      // read every region
+      // read every region, malformed regions are left out
       for ( size_t i = 0; i < region_count; ++i )
-        sin >> garbage >> true_regions[index].labels[i]
-            >> true_regions[index].regions[i].x
-            >> true_regions[index].regions[i].y
-            >> true_regions[index].regions[i].width
-            >> true_regions[index].regions[i].height;
+      {
+        string label;
+        cv::Rect roi;
+        RegionShape shape;
+
+        sin >> garbage >> label;
+        if ( !ReadRegion(sin, false, roi, shape) )
+        {
+          // after an unknown keyword the rest of the line can't be read
+          RegionError(file_path, line_number, i);
+          if ( !sin )
+            break;
+          continue;
+        }
+
+        true_regions[index].labels.push_back(label);
+        true_regions[index].regions.push_back(roi);
+        true_regions[index].shapes.push_back(shape);
+        true_regions[index].size_buckets.push_back(
+          SizeBucket(roi, size_buckets));
+      }
 
       ++index;
+      ++line_number;
       getline(fin, line);
     }
   }
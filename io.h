@@ -1,10 +1,13 @@
 #ifndef ANALYSIS_IO
 #define ANALYSIS_IO
 
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <vector>
 #include <boost/filesystem.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/utility.hpp>
 #include "image_region_list.h"
 
 #define BOOST_FILESYSTEM_VERSION 3
@@ -15,12 +18,14 @@
 |   Input:                                                                     |
 |     filename: Path to the file containined the computed ROIs                 |
 |     score_threshold: minimum score to accept                                 |
+|     size_buckets: lower area bound of each size bucket, ascending            |
 |   Output:                                                                    |
 |     computed_regions: List of computed regions                               |
 \******************************************************************************/
 bool LoadComputedROI( 
   const boost::filesystem::path&  filename,
   double score_threshold,
+  const std::vector<double>&      size_buckets,
   std::vector<ImageRegionList>&   computed_regions 
 );
 
@@ -29,13 +34,75 @@ bool LoadComputedROI(
 |                interest(ROIs)                                                |
 |   Input:                                                                     |
 |     filename: Path to the file containined the computed ROIs                 |
+|     size_buckets: lower area bound of each size bucket, ascending            |
 |   Output:                                                                    |
 |     true_regions: List of true regions                                       |
 \******************************************************************************/
 bool LoadTrueROI(
   const boost::filesystem::path&  filename,
+  const std::vector<double>&      size_buckets,
   std::vector<ImageRegionList>&   true_regions
 );
 
+/**BufferedWriter**************************************************************\
+|   Description: Writes a file through one large buffer.  The file is opened   |
+|                once and numbers are formatted straight into the buffer, so   |
+|                writing never allocates and only full buffers reach the file. |
+\******************************************************************************/
+class BufferedWriter : boost::noncopyable
+{
+  public:
+    explicit BufferedWriter( size_t buffer_size = 1 << 20 );
+    ~BufferedWriter();
+
+    // opens (truncates) the file, false if it can't be opened
+    bool Open( const boost::filesystem::path& filename, bool binary = false );
+
+    // flushes and closes the file, false if any write failed
+    bool Close();
+
+    BufferedWriter& Write( const char* text, size_t length );
+    BufferedWriter& Write( const char* text );
+    BufferedWriter& Write( const std::string& text );
+    BufferedWriter& Write( char c );
+    BufferedWriter& Write( long value );
+
+    // numbers are written with the fewest significant digits that read back
+    // as the same value unless a precision is given
+    BufferedWriter& Write( float value, int precision = 0 );
+    BufferedWriter& Write( double value, int precision = 0 );
+
+  private:
+    // writes the buffered text to the file
+    void Flush();
+
+    // makes room for at least length characters
+    void Reserve( size_t length )
+    { if ( used_ + length > size_ ) Flush(); }
+
+    FILE*                     file_;
+    boost::scoped_array<char> buffer_;
+    size_t                    size_;
+    size_t                    used_;
+    bool                      failed_;
+};
+
+/**WriteRegion*****************************************************************\
+|   Description: Write the geometry of one region in the form read by the      |
+|                loaders above                                                 |
+|   Input:                                                                     |
+|     roi/shape: region to write                                               |
+|     corners: write rectangles as corners (computed format) instead of        |
+|              <x> <y> <width> <height> (true format)                          |
+|   Output:                                                                    |
+|     out: writer the region is appended to                                    |
+\******************************************************************************/
+void WriteRegion(
+  BufferedWriter&     out,
+  const cv::Rect&     roi,
+  const RegionShape&  shape,
+  bool                corners
+);
+
 #endif // ANALYSIS_IO
 
@@ -0,0 +1,178 @@
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "match_dump.h"
+
+namespace fs = boost::filesystem;
+
+///////////////////////// LOCAL FUNCTIONS //////////////////////////////////////
+
+// rounds a byte count up to the next multiple of 8
+boost::uint64_t Pad8( boost::uint64_t bytes )
+{
+  return ( bytes + 7 ) & ~static_cast<boost::uint64_t>(7);
+}
+
+// bytes taken by a string table
+boost::uint64_t StringsSize( const std::vector<std::string>& strings )
+{
+  boost::uint64_t bytes = 0;
+  for ( size_t i = 0; i < strings.size(); ++i )
+    bytes += sizeof(boost::uint32_t) + strings[i].size();
+  return Pad8(bytes);
+}
+
+//////////////////////// GLOBAL FUNCTIONS //////////////////////////////////////
+
+bool MatchDumpWriter::Open( const fs::path& filename,
+  boost::uint64_t row_count, const std::vector<std::string>& images,
+  const std::vector<std::string>& labels )
+{
+  if ( !out_.Open(filename, true) )
+    return false;
+
+  images_ = images;
+  labels_ = labels;
+  column_ = 0;
+  written_ = 0;
+
+  // every offset follows from the row count and the string tables
+  memset(&header_, 0, sizeof(header_));
+  memcpy(header_.magic, MATCH_DUMP_MAGIC, sizeof(header_.magic));
+  header_.version = MATCH_DUMP_VERSION;
+  header_.column_count = MATCH_COLUMNS;
+  header_.row_count = row_count;
+
+  boost::uint64_t offset = Pad8(sizeof(MatchDumpHeader));
+  for ( int i = 0; i < MATCH_COLUMNS; ++i )
+  {
+    header_.column_offset[i] = offset;
+    offset += Pad8(row_count * MATCH_COLUMN_WIDTH[i]);
+  }
+  header_.image_offset = offset;
+  header_.image_count = images_.size();
+  header_.label_offset = offset + StringsSize(images_);
+  header_.label_count = labels_.size();
+
+  out_.Write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+  for ( size_t i = sizeof(header_); i < Pad8(sizeof(header_)); ++i )
+    out_.Write('\0');
+  return true;
+}
+
+void MatchDumpWriter::PutBytes( const void* value, size_t length )
+{
+  out_.Write(static_cast<const char*>(value), length);
+  written_ += length;
+}
+
+void MatchDumpWriter::EndColumn()
+{
+  for ( ; written_ < Pad8(written_); ++written_ )
+    out_.Write('\0');
+  ++column_;
+  written_ = 0;
+}
+
+void MatchDumpWriter::WriteStrings( const std::vector<std::string>& strings )
+{
+  boost::uint64_t bytes = 0;
+  for ( size_t i = 0; i < strings.size(); ++i )
+  {
+    boost::uint32_t length = strings[i].size();
+    out_.Write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out_.Write(strings[i]);
+    bytes += sizeof(length) + length;
+  }
+  for ( ; bytes < Pad8(bytes); ++bytes )
+    out_.Write('\0');
+}
+
+bool MatchDumpWriter::Close()
+{
+  bool complete = ( column_ == MATCH_COLUMNS );
+  if ( complete )
+  {
+    WriteStrings(images_);
+    WriteStrings(labels_);
+  }
+  column_ = 0;
+  return out_.Close() && complete;
+}
+
+bool MatchDump::Open( const fs::path& filename )
+{
+  Close();
+
+  int file = open(filename.string().c_str(), O_RDONLY);
+  if ( file < 0 )
+    return false;
+
+  struct stat info;
+  void* map = MAP_FAILED;
+  if ( fstat(file, &info) == 0 &&
+       info.st_size >= static_cast<off_t>(sizeof(MatchDumpHeader)) )
+    map = mmap(0, info.st_size, PROT_READ, MAP_SHARED, file, 0);
+  close(file);
+  if ( map == MAP_FAILED )
+    return false;
+
+  data_ = static_cast<const char*>(map);
+  size_ = info.st_size;
+  header_ = reinterpret_cast<const MatchDumpHeader*>(data_);
+
+  // check the header before trusting any offset in it
+  bool valid =
+    memcmp(header_->magic, MATCH_DUMP_MAGIC, sizeof(header_->magic)) == 0 &&
+    header_->version == MATCH_DUMP_VERSION &&
+    header_->column_count == MATCH_COLUMNS &&
+    header_->row_count <= size_;
+  for ( int i = 0; valid && i < MATCH_COLUMNS; ++i )
+    valid = header_->column_offset[i] % 8 == 0 &&
+            header_->column_offset[i] <= size_ &&
+            header_->row_count * MATCH_COLUMN_WIDTH[i] <=
+              size_ - header_->column_offset[i];
+  valid = valid &&
+          ReadStrings(header_->image_offset, header_->image_count, images_) &&
+          ReadStrings(header_->label_offset, header_->label_count, labels_);
+
+  // the ids index the string tables
+  for ( size_t i = 0; valid && i < Rows(); ++i )
+    valid = ImageIds()[i] < images_.size() && LabelIds()[i] < labels_.size();
+
+  if ( !valid )
+    Close();
+  return valid;
+}
+
+void MatchDump::Close()
+{
+  if ( data_ )
+    munmap(const_cast<char*>(data_), size_);
+  data_ = 0;
+  size_ = 0;
+  header_ = 0;
+  images_.clear();
+  labels_.clear();
+}
+
+bool MatchDump::ReadStrings( boost::uint64_t offset, boost::uint64_t count,
+  std::vector<StringRef>& strings ) const
+{
+  strings.clear();
+  for ( boost::uint64_t i = 0; i < count; ++i )
+  {
+    boost::uint32_t length;
+    if ( offset > size_ || size_ - offset < sizeof(length) )
+      return false;
+    memcpy(&length, data_ + offset, sizeof(length));
+    offset += sizeof(length);
+    if ( size_ - offset < length )
+      return false;
+    strings.push_back(StringRef(data_ + offset, length));
+    offset += length;
+  }
+  return true;
+}
@@ -0,0 +1,160 @@
+//
+// Description : Binary dump of every scored (true, computed) pair from the
+//               match stage so the matches can be sliced later without
+//               running the matching again.
+//
+// The file is columnar with fixed width values in native byte order:
+//
+//   header     MatchDumpHeader (magic "ATMATCH1")
+//   columns    one array of row_count values per column, in MatchColumn
+//              order, each padded to a multiple of 8 bytes
+//   images     image_count strings (uint32 length followed by the bytes)
+//   labels     label_count strings in the same form
+//
+// Every column starts at the offset stored in the header, so a column can
+// be read straight out of a memory map (MatchDump does this) or loaded with
+// e.g. numpy.memmap and converted to Arrow/Parquet offline.
+//
+
+#ifndef ANALYSIS_MATCH_DUMP
+#define ANALYSIS_MATCH_DUMP
+
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/utility.hpp>
+#include "io.h"
+
+#define BOOST_FILESYSTEM_VERSION 3
+#define BOOST_FILESYSTEM_NO_DEPRECATED
+
+// columns of the dump in file order
+typedef enum {
+  MATCH_IMAGE    = 0,   // uint32 image index
+  MATCH_TRUTH    = 1,   // uint32 true region index within the image
+  MATCH_COMPUTED = 2,   // uint32 computed region index within the image
+  MATCH_IOU      = 3,   // float64 overlap score
+  MATCH_SCORE    = 4,   // float32 score of the computed region
+  MATCH_LABEL    = 5,   // uint32 index of the computed region's label
+  MATCH_COLUMNS  = 6
+} MatchColumn;
+
+// bytes per value of each column
+const size_t MATCH_COLUMN_WIDTH[MATCH_COLUMNS] = { 4, 4, 4, 8, 4, 4 };
+
+const char MATCH_DUMP_MAGIC[8] = { 'A','T','M','A','T','C','H','1' };
+const boost::uint32_t MATCH_DUMP_VERSION = 1;
+
+struct MatchDumpHeader
+{
+  char            magic[8];
+  boost::uint32_t version;
+  boost::uint32_t column_count;
+  boost::uint64_t row_count;
+  boost::uint64_t column_offset[MATCH_COLUMNS];
+  boost::uint64_t image_offset;
+  boost::uint64_t image_count;
+  boost::uint64_t label_offset;
+  boost::uint64_t label_count;
+};
+
+/**MatchDumpWriter*************************************************************\
+|   Description: Writes a match dump through a BufferedWriter.  The number of  |
+|                rows and the string tables are given up front so the header   |
+|                can be written first, then every column is filled in order    |
+|                with Put() and ended with EndColumn().                        |
+\******************************************************************************/
+class MatchDumpWriter : boost::noncopyable
+{
+  public:
+    MatchDumpWriter() : column_(0), written_(0) {}
+
+    // writes the header, false if the file can't be opened
+    bool Open( const boost::filesystem::path&  filename,
+               boost::uint64_t                 row_count,
+               const std::vector<std::string>& images,
+               const std::vector<std::string>& labels );
+
+    // append one value to the current column
+    void Put( boost::uint32_t value ) { PutBytes(&value, sizeof(value)); }
+    void Put( float value )           { PutBytes(&value, sizeof(value)); }
+    void Put( double value )          { PutBytes(&value, sizeof(value)); }
+
+    // pads the current column and moves on to the next one
+    void EndColumn();
+
+    // writes the string tables and closes the file, false if the columns
+    // were not all filled or a write failed
+    bool Close();
+
+  private:
+    void PutBytes( const void* value, size_t length );
+    void WriteStrings( const std::vector<std::string>& strings );
+
+    BufferedWriter            out_;
+    MatchDumpHeader           header_;
+    std::vector<std::string>  images_, labels_;
+    int                       column_;
+    boost::uint64_t           written_;  // bytes of the current column
+};
+
+/**MatchDump*******************************************************************\
+|   Description: Read only view of a match dump through a memory map.  The     |
+|                column pointers stay valid until Close() or destruction.      |
+\******************************************************************************/
+class MatchDump : boost::noncopyable
+{
+  public:
+    MatchDump() : data_(0), size_(0), header_(0) {}
+    ~MatchDump() { Close(); }
+
+    // maps the file and checks its layout and that every image and label id
+    // is in its string table, false if it isn't a valid dump
+    bool Open( const boost::filesystem::path& filename );
+    void Close();
+
+    size_t Rows() const { return header_ ? header_->row_count : 0; }
+
+    const boost::uint32_t* ImageIds() const
+    { return Column<boost::uint32_t>(MATCH_IMAGE); }
+    const boost::uint32_t* TruthIds() const
+    { return Column<boost::uint32_t>(MATCH_TRUTH); }
+    const boost::uint32_t* ComputedIds() const
+    { return Column<boost::uint32_t>(MATCH_COMPUTED); }
+    const double* Ious() const
+    { return Column<double>(MATCH_IOU); }
+    const float* Scores() const
+    { return Column<float>(MATCH_SCORE); }
+    const boost::uint32_t* LabelIds() const
+    { return Column<boost::uint32_t>(MATCH_LABEL); }
+
+    size_t ImageCount() const { return images_.size(); }
+    std::string ImagePath( size_t index ) const
+    { return std::string(images_[index].first, images_[index].second); }
+
+    size_t LabelCount() const { return labels_.size(); }
+    std::string Label( size_t index ) const
+    { return std::string(labels_[index].first, labels_[index].second); }
+
+  private:
+    typedef std::pair<const char*, size_t> StringRef;
+
+    template <typename T>
+    const T* Column( MatchColumn column ) const
+    {
+      return header_ ? reinterpret_cast<const T*>(
+        data_ + header_->column_offset[column]) : 0;
+    }
+
+    // finds count strings starting at offset, false if they run off the end
+    bool ReadStrings( boost::uint64_t offset, boost::uint64_t count,
+                      std::vector<StringRef>& strings ) const;
+
+    const char*             data_;
+    size_t                  size_;
+    const MatchDumpHeader*  header_;
+    std::vector<StringRef>  images_, labels_;
+};
+
+#endif // ANALYSIS_MATCH_DUMP
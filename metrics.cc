@@ -0,0 +1,428 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <boost/scoped_array.hpp>
+#include "metrics.h"
+#include "parallel.h"
+#include "io.h"
+
+///////////////////////// LOCAL FUNCTIONS //////////////////////////////////////
+
+double Ratio( double numerator, double denominator )
+{
+  return denominator > 0.0 ? numerator / denominator : 0.0;
+}
+
+// value at quantile q of a sorted list, interpolated between neighbours
+double Quantile( const std::vector<double>& sorted, double q )
+{
+  if ( sorted.empty() )
+    return 0.0;
+
+  double position = q * ( sorted.size() - 1 );
+  size_t below = static_cast<size_t>(std::floor(position));
+  size_t above = std::min(below + 1, sorted.size() - 1);
+  double fraction = position - below;
+  return sorted[below] + fraction * ( sorted[above] - sorted[below] );
+}
+
+// fills in the interval of a statistic from its resampled values
+void SetInterval( std::vector<double>& values, double level,
+  Interval& interval )
+{
+  std::sort(values.begin(), values.end());
+  interval.lower = Quantile(values, 0.5 * ( 1.0 - level ));
+  interval.upper = Quantile(values, 1.0 - 0.5 * ( 1.0 - level ));
+}
+
+// writes the summary and bins of one quantity as a csv row
+void WriteLocalizationRow( BufferedWriter& out, const std::string& label,
+  const LocalizationHistogram& histogram, int quantity )
+{
+  static const double QUANTILES[] = { 0.05, 0.25, 0.5, 0.75, 0.95 };
+
+  out.Write(label).Write(',').Write(LOCALIZATION_NAMES[quantity]).Write(',')
+     .Write(static_cast<long>(histogram.pairs)).Write(',')
+     .Write(static_cast<long>(histogram.degenerate)).Write(',')
+     .Write(LOCALIZATION_RANGE[quantity][0]).Write(',')
+     .Write(LOCALIZATION_RANGE[quantity][1]).Write(',')
+     .Write(static_cast<long>(histogram.underflow[quantity])).Write(',')
+     .Write(static_cast<long>(histogram.overflow[quantity]));
+  for ( size_t i = 0; i < sizeof(QUANTILES) / sizeof(QUANTILES[0]); ++i )
+  {
+    double value = LocalizationQuantile(histogram,
+      static_cast<LocalizationHistogram::Quantity>(quantity), QUANTILES[i]);
+    out.Write(',');
+    if ( value < LOCALIZATION_RANGE[quantity][0] )
+      out.Write('<').Write(LOCALIZATION_RANGE[quantity][0]);
+    else if ( value > LOCALIZATION_RANGE[quantity][1] )
+      out.Write('>').Write(LOCALIZATION_RANGE[quantity][1]);
+    else
+      out.Write(value, 6);  // only as exact as the bin width
+  }
+  for ( int i = 0; i < LocalizationHistogram::BINS; ++i )
+    out.Write(',').Write(static_cast<long>(histogram.counts[quantity][i]));
+  out.Write('\n');
+}
+
+// orders events from the highest score down
+bool ScoreGreater( const ScoredEvent& lhs, const ScoredEvent& rhs )
+{
+  return lhs.score > rhs.score;
+}
+
+// one bootstrap resample, used with ParallelFor() by BootstrapMetrics().
+// The images drawn are turned into a count per image first so the totals
+// are plain integer dot products over contiguous arrays.
+struct BootstrapSample
+{
+  BootstrapSample( const std::vector<boost::int32_t>& tp,
+    const std::vector<boost::int32_t>& fp,
+    const std::vector<boost::int32_t>& fn, boost::uint64_t seed,
+    std::vector<boost::int32_t>* weights, std::vector<double>& detection_rate,
+    std::vector<double>& precision, std::vector<double>& fp_per_image ) :
+    tp(tp), fp(fp), fn(fn), seed(seed), weights(weights),
+    detection_rate(detection_rate), precision(precision),
+    fp_per_image(fp_per_image) {}
+
+  void operator()( size_t sample, int thread )
+  {
+    const size_t images = tp.size();
+    std::vector<boost::int32_t>& w = weights[thread];
+    w.assign(images, 0);
+
+    // draw i of this sample is key + i, the top 32 bits of each value are
+    // scaled to an image index
+    boost::uint64_t key = CounterRandom(seed + CounterRandom(sample));
+    for ( size_t i = 0; i < images; ++i )
+      ++w[( ( CounterRandom(key + i) >> 32 ) * images ) >> 32];
+
+    boost::int64_t tp_sum = 0, fp_sum = 0, fn_sum = 0;
+    for ( size_t i = 0; i < images; ++i )
+    {
+      tp_sum += w[i] * tp[i];
+      fp_sum += w[i] * fp[i];
+      fn_sum += w[i] * fn[i];
+    }
+
+    detection_rate[sample] = Ratio(tp_sum, tp_sum + fn_sum);
+    precision[sample] = Ratio(tp_sum, tp_sum + fp_sum);
+    fp_per_image[sample] = Ratio(fp_sum, images);
+  }
+
+  const std::vector<boost::int32_t>&  tp;
+  const std::vector<boost::int32_t>&  fp;
+  const std::vector<boost::int32_t>&  fn;
+  boost::uint64_t                     seed;
+  std::vector<boost::int32_t>*        weights;
+  std::vector<double>&                detection_rate;
+  std::vector<double>&                precision;
+  std::vector<double>&                fp_per_image;
+};
+
+// one sign flip permutation, used with ParallelFor() by
+// PairedPermutationTest().  Every draw gives the signs of 64 images.
+struct SignFlipSample
+{
+  SignFlipSample( const std::vector<boost::int32_t>& differences,
+    boost::int64_t observed, boost::uint64_t seed,
+    std::vector<unsigned char>& extreme ) :
+    differences(differences), observed(observed), seed(seed),
+    extreme(extreme) {}
+
+  void operator()( size_t sample, int /*thread*/ )
+  {
+    boost::uint64_t key = CounterRandom(seed + CounterRandom(sample));
+    boost::uint64_t signs = 0;
+    boost::int64_t sum = 0;
+    for ( size_t i = 0; i < differences.size(); ++i )
+    {
+      if ( i % 64 == 0 )
+        signs = CounterRandom(key + i / 64);
+      sum += ( signs & 1 ) ? -differences[i] : differences[i];
+      signs >>= 1;
+    }
+    extreme[sample] = ( sum < 0 ? -sum : sum ) >= observed;
+  }
+
+  const std::vector<boost::int32_t>&  differences;
+  boost::int64_t                      observed;
+  boost::uint64_t                     seed;
+  std::vector<unsigned char>&         extreme;
+};
+
+//////////////////////// GLOBAL FUNCTIONS //////////////////////////////////////
+
+const char* const LOCALIZATION_NAMES[LocalizationHistogram::QUANTITIES] =
+  { "iou", "center_dx", "center_dy", "log_width", "log_height" };
+
+const double LOCALIZATION_RANGE[LocalizationHistogram::QUANTITIES][2] =
+  { { 0.0, 1.0 }, { -0.5, 0.5 }, { -0.5, 0.5 }, { -1.0, 1.0 }, { -1.0, 1.0 } };
+
+LocalizationHistogram::LocalizationHistogram() : pairs(0), degenerate(0)
+{
+  memset(underflow, 0, sizeof(underflow));
+  memset(overflow, 0, sizeof(overflow));
+  memset(counts, 0, sizeof(counts));
+}
+
+void LocalizationHistogram::Add( double iou, double center_dx,
+  double center_dy, double log_width, double log_height )
+{
+  const double values[QUANTITIES] =
+    { iou, center_dx, center_dy, log_width, log_height };
+
+  for ( int i = 0; i < QUANTITIES; ++i )
+  {
+    const double lower = LOCALIZATION_RANGE[i][0];
+    const double upper = LOCALIZATION_RANGE[i][1];
+
+    if ( values[i] < lower )
+      ++underflow[i];
+    else if ( values[i] > upper )
+      ++overflow[i];
+    else
+    {
+      // the last bin also holds the upper bound, e.g. an IoU of 1
+      int bin = static_cast<int>(( values[i] - lower ) / ( upper - lower ) *
+                                 BINS);
+      ++counts[i][std::min(bin, BINS - 1)];
+    }
+  }
+  ++pairs;
+}
+
+LocalizationHistogram& LocalizationHistogram::operator+= (
+  const LocalizationHistogram& other )
+{
+  pairs += other.pairs;
+  degenerate += other.degenerate;
+  for ( int i = 0; i < QUANTITIES; ++i )
+  {
+    underflow[i] += other.underflow[i];
+    overflow[i] += other.overflow[i];
+    for ( int j = 0; j < BINS; ++j )
+      counts[i][j] += other.counts[i][j];
+  }
+  return *this;
+}
+
+double LocalizationQuantile( const LocalizationHistogram& histogram,
+  LocalizationHistogram::Quantity quantity, double q )
+{
+  if ( histogram.pairs == 0 )
+    return 0.0;
+
+  const double lower = LOCALIZATION_RANGE[quantity][0];
+  const double width = ( LOCALIZATION_RANGE[quantity][1] - lower ) /
+                       LocalizationHistogram::BINS;
+  const boost::int64_t* counts = histogram.counts[quantity];
+
+  // below or above the range nothing is known but the side
+  double target = q * histogram.pairs;
+  double below = static_cast<double>(histogram.underflow[quantity]);
+  if ( below > 0.0 && target <= below )
+    return -std::numeric_limits<double>::infinity();
+
+  // first bin the cumulative count reaches the target in
+  int bin = 0;
+  while ( bin < LocalizationHistogram::BINS && below + counts[bin] < target )
+    below += counts[bin++];
+  if ( bin == LocalizationHistogram::BINS )
+    return std::numeric_limits<double>::infinity();
+
+  double fraction = counts[bin] > 0 ? ( target - below ) / counts[bin] : 0.0;
+  return lower + width * ( bin + std::max(0.0, std::min(1.0, fraction)) );
+}
+
+bool WriteLocalization( const boost::filesystem::path& filename,
+  const std::vector<std::string>& labels,
+  const std::vector<LocalizationHistogram>& histograms )
+{
+  BufferedWriter out;
+  if ( !out.Open(filename) )
+    return false;
+
+  out.Write("label,quantity,pairs,degenerate,range_lo,range_hi,underflow,"
+            "overflow,p05,p25,p50,p75,p95");
+  for ( int i = 0; i < LocalizationHistogram::BINS; ++i )
+    out.Write(",bin_").Write(static_cast<long>(i));
+  out.Write('\n');
+
+  LocalizationHistogram all;
+  for ( size_t i = 0; i < histograms.size(); ++i )
+  {
+    all += histograms[i];
+    for ( int j = 0; j < LocalizationHistogram::QUANTITIES; ++j )
+      WriteLocalizationRow(out, labels[i], histograms[i], j);
+  }
+  for ( int j = 0; j < LocalizationHistogram::QUANTITIES; ++j )
+    WriteLocalizationRow(out, "*", all, j);
+  return out.Close();
+}
+
+void DetectionCurve( std::vector<ScoredEvent>& events,
+  std::vector<CurvePoint>& curve )
+{
+  curve.clear();
+  std::sort(events.begin(), events.end(), ScoreGreater);
+
+  // a point is added once every event with the same score is counted
+  CurvePoint point;
+  for ( size_t i = 0; i < events.size(); ++i )
+  {
+    switch ( events[i].type )
+    {
+      case ScoredEvent::MATCHED_DETECTION: ++point.true_detections;  break;
+      case ScoredEvent::FALSE_DETECTION:   ++point.false_detections; break;
+      case ScoredEvent::DETECTED_TRUTH:    ++point.truths_found;     break;
+    }
+    if ( i + 1 == events.size() || events[i + 1].score != events[i].score )
+    {
+      point.score = events[i].score;
+      curve.push_back(point);
+    }
+  }
+}
+
+bool WritePRCurve( const boost::filesystem::path& filename,
+  const std::vector<CurvePoint>& curve, int total_truth )
+{
+  BufferedWriter out;
+  if ( !out.Open(filename) )
+    return false;
+
+  out.Write("score,precision,recall,true_detections,false_detections,"
+            "truths_found\n");
+  for ( size_t i = 0; i < curve.size(); ++i )
+  {
+    const CurvePoint& p = curve[i];
+    out.Write(p.score, 9).Write(',')
+       .Write(Ratio(p.true_detections,
+                    p.true_detections + p.false_detections), 9).Write(',')
+       .Write(Ratio(p.truths_found, total_truth), 9).Write(',')
+       .Write(static_cast<long>(p.true_detections)).Write(',')
+       .Write(static_cast<long>(p.false_detections)).Write(',')
+       .Write(static_cast<long>(p.truths_found)).Write('\n');
+  }
+  return out.Close();
+}
+
+double AveragePrecision( const std::vector<CurvePoint>& curve,
+  int total_truth )
+{
+  if ( total_truth <= 0 )
+    return 0.0;
+
+  // from the lowest score up, so the best precision seen so far is the best
+  // at this recall or any higher one
+  double area = 0.0, best = 0.0;
+  for ( size_t i = curve.size(); i-- > 0; )
+  {
+    best = std::max(best, Ratio(curve[i].true_detections,
+      curve[i].true_detections + curve[i].false_detections));
+    int found = curve[i].truths_found;
+    if ( i > 0 )
+      found -= curve[i - 1].truths_found;
+    area += found * best;
+  }
+  return area / total_truth;
+}
+
+void FrocSensitivity( const std::vector<CurvePoint>& curve, int total_truth,
+  int images, const double* rates, int count,
+  std::vector<double>& sensitivity )
+{
+  sensitivity.assign(count, 0.0);
+  if ( images <= 0 || total_truth <= 0 )
+    return;
+
+  // walk the curve and the rates together, (fp, found) is the last point at
+  // or below the current rate
+  double fp = 0.0, found = 0.0;
+  size_t next = 0;
+  for ( int i = 0; i < count; ++i )
+  {
+    while ( next < curve.size() &&
+            Ratio(curve[next].false_detections, images) <= rates[i] )
+    {
+      fp = Ratio(curve[next].false_detections, images);
+      found = Ratio(curve[next].truths_found, total_truth);
+      ++next;
+    }
+
+    if ( next == curve.size() )
+      sensitivity[i] = found;
+    else
+    {
+      double next_fp = Ratio(curve[next].false_detections, images);
+      double next_found = Ratio(curve[next].truths_found, total_truth);
+      sensitivity[i] = found +
+        ( rates[i] - fp ) / ( next_fp - fp ) * ( next_found - found );
+    }
+  }
+}
+
+void BootstrapMetrics( const std::vector<ImageCounts>& counts, int samples,
+  double level, boost::uint64_t seed, int num_threads,
+  BootstrapResult& result )
+{
+  // counts as separate arrays
+  std::vector<boost::int32_t> tp(counts.size()), fp(counts.size()),
+                              fn(counts.size());
+  boost::int64_t tp_total = 0, fp_total = 0, fn_total = 0;
+  for ( size_t i = 0; i < counts.size(); ++i )
+  {
+    tp_total += tp[i] = counts[i].true_positives;
+    fp_total += fp[i] = counts[i].false_positives;
+    fn_total += fn[i] = counts[i].false_negatives;
+  }
+
+  result = BootstrapResult();
+  result.detection_rate.value = Ratio(tp_total, tp_total + fn_total);
+  result.precision.value = Ratio(tp_total, tp_total + fp_total);
+  result.fp_per_image.value = Ratio(fp_total, counts.size());
+  result.detection_rate.lower = result.detection_rate.upper =
+    result.detection_rate.value;
+  result.precision.lower = result.precision.upper = result.precision.value;
+  result.fp_per_image.lower = result.fp_per_image.upper =
+    result.fp_per_image.value;
+  if ( samples <= 0 || counts.empty() )
+    return;
+
+  std::vector<double> detection_rate(samples), precision(samples),
+                      fp_per_image(samples);
+  boost::scoped_array< std::vector<boost::int32_t> >
+    weights(new std::vector<boost::int32_t>[num_threads]);
+  BootstrapSample sample(tp, fp, fn, seed, weights.get(), detection_rate,
+                         precision, fp_per_image);
+  ParallelFor(samples, num_threads, sample);
+
+  SetInterval(detection_rate, level, result.detection_rate);
+  SetInterval(precision, level, result.precision);
+  SetInterval(fp_per_image, level, result.fp_per_image);
+}
+
+double PairedPermutationTest( const std::vector<boost::int32_t>& differences,
+  int samples, boost::uint64_t seed, int num_threads )
+{
+  if ( samples <= 0 )
+    return 1.0;
+
+  boost::int64_t observed = 0;
+  for ( size_t i = 0; i < differences.size(); ++i )
+    observed += differences[i];
+  if ( observed < 0 )
+    observed = -observed;
+
+  // one flag per permutation so no two threads write the same counter
+  std::vector<unsigned char> extreme(samples, 0);
+  SignFlipSample sample(differences, observed, seed, extreme);
+  ParallelFor(samples, num_threads, sample);
+
+  int count = 0;
+  for ( int i = 0; i < samples; ++i )
+    count += extreme[i];
+  return ( 1.0 + count ) / ( 1.0 + samples );
+}
@@ -0,0 +1,283 @@
+//
+// Description : Summary statistics computed from the match results.
+//
+// The match stage is reduced to plain per-image counts or scored events
+// first, everything here works from those so the regions and matches are not
+// needed again.
+//
+// DetectionCurve() sweeps every detection score once from one sort of all
+// the detections and detected ground truth, so the precision-recall curve has
+// a point for every distinct score at O(N log N) cost.  The FROC curve is
+// read off the same points.
+//
+// BootstrapMetrics() resamples images with replacement.  Each resample draws
+// its images from a counter based generator keyed on (seed, resample, draw),
+// so the intervals only depend on the seed and not on the number of threads.
+// PairedPermutationTest() draws its sign flips the same way.
+//
+
+#ifndef ANALYSIS_METRICS
+#define ANALYSIS_METRICS
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/filesystem.hpp>
+
+#define BOOST_FILESYSTEM_VERSION 3
+#define BOOST_FILESYSTEM_NO_DEPRECATED
+
+// detection counts of one image
+struct ImageCounts
+{
+  ImageCounts() : true_positives(0), false_positives(0), false_negatives(0) {}
+
+  int true_positives;   // ground truth regions that were detected
+  int false_positives;  // computed regions that match no ground truth
+  int false_negatives;  // ground truth regions that were missed
+};
+
+// a statistic with its percentile bootstrap confidence interval
+struct Interval
+{
+  Interval() : value(0.0), lower(0.0), upper(0.0) {}
+
+  double value;   // statistic of the full set of images
+  double lower;
+  double upper;
+};
+
+struct BootstrapResult
+{
+  Interval detection_rate;  // TP / (TP + FN)
+  Interval precision;       // TP / (TP + FP)
+  Interval fp_per_image;    // FP / images
+};
+
+// a computed region, or a ground truth region at the best score of the
+// computed regions matching it, placed on the score axis
+struct ScoredEvent
+{
+  typedef enum {
+    MATCHED_DETECTION = 0,  // computed region matching a ground truth
+    FALSE_DETECTION   = 1,  // computed region matching nothing
+    DETECTED_TRUTH    = 2   // ground truth region found at this score
+  } EventType;
+
+  ScoredEvent() : score(0.0), type(FALSE_DETECTION) {}
+  ScoredEvent(double s, EventType t) : score(s), type(t) {}
+
+  double    score;
+  EventType type;
+};
+
+// running counts of everything scoring at least score
+struct CurvePoint
+{
+  CurvePoint() : score(0.0), true_detections(0), false_detections(0),
+    truths_found(0) {}
+
+  double score;
+  int    true_detections;
+  int    false_detections;
+  int    truths_found;
+};
+
+/**DetectionCurve**************************************************************\
+|   Description: One point per distinct score, from the highest score down.    |
+|                Precision at a point is true/(true + false) detections and    |
+|                recall is truths_found over the number of ground truths.      |
+|   Input:                                                                     |
+|     events: detections and detected truths, sorted in place                  |
+|   Output:                                                                    |
+|     curve: running counts at each distinct score                             |
+\******************************************************************************/
+void DetectionCurve(
+  std::vector<ScoredEvent>& events,
+  std::vector<CurvePoint>&  curve
+);
+
+/**WritePRCurve****************************************************************\
+|   Description: Write the precision-recall curve as csv                       |
+|                (score,precision,recall,true_detections,false_detections,     |
+|                truths_found)                                                 |
+|   Input:                                                                     |
+|     filename: file to write                                                  |
+|     curve: output from DetectionCurve()                                      |
+|     total_truth: number of ground truth regions                              |
+|   Output: false if the file could not be written                             |
+\******************************************************************************/
+bool WritePRCurve(
+  const boost::filesystem::path&  filename,
+  const std::vector<CurvePoint>&  curve,
+  int                             total_truth
+);
+
+/**AveragePrecision************************************************************\
+|   Description: Area under the precision-recall curve with every precision    |
+|                raised to the best precision at the same or higher recall     |
+|                (all point interpolation)                                     |
+|   Input:                                                                     |
+|     curve: output from DetectionCurve()                                      |
+|     total_truth: number of ground truth regions                              |
+|   Output: average precision, 0 without ground truth                          |
+\******************************************************************************/
+double AveragePrecision(
+  const std::vector<CurvePoint>&  curve,
+  int                             total_truth
+);
+
+// standard FROC operating points in false positives per image
+const int FROC_POINTS = 7;
+const double FROC_FP_RATES[FROC_POINTS] =
+  { 0.125, 0.25, 0.5, 1.0, 2.0, 4.0, 8.0 };
+
+/**FrocSensitivity*************************************************************\
+|   Description: Sensitivity (truths_found over the number of ground truths)   |
+|                at each false positive per image rate.  The curve starts at   |
+|                (0, 0) and is interpolated linearly between its points,       |
+|                rates past its end get the final sensitivity.                 |
+|   Input:                                                                     |
+|     curve: output from DetectionCurve()                                      |
+|     total_truth: number of ground truth regions                              |
+|     images: number of images                                                 |
+|     rates: false positives per image, ascending                              |
+|     count: number of rates                                                   |
+|   Output:                                                                    |
+|     sensitivity: sensitivity at each rate                                    |
+\******************************************************************************/
+void FrocSensitivity(
+  const std::vector<CurvePoint>&  curve,
+  int                             total_truth,
+  int                             images,
+  const double*                   rates,
+  int                             count,
+  std::vector<double>&            sensitivity
+);
+
+// fixed bin histograms of the localization error of matched pairs
+struct LocalizationHistogram
+{
+  typedef enum {
+    IOU        = 0,   // overlap score of the pair
+    CENTER_DX  = 1,   // center x offset over the true width
+    CENTER_DY  = 2,   // center y offset over the true height
+    LOG_WIDTH  = 3,   // ln(computed width / true width)
+    LOG_HEIGHT = 4    // ln(computed height / true height)
+  } Quantity;
+
+  static const int QUANTITIES = 5;
+  static const int BINS = 100;
+
+  LocalizationHistogram();
+
+  // adds one pair, values outside the range of a quantity are only counted
+  // as underflow or overflow
+  void Add( double iou, double center_dx, double center_dy, double log_width,
+    double log_height );
+
+  LocalizationHistogram& operator+= ( const LocalizationHistogram& other );
+
+  boost::int64_t pairs;
+  boost::int64_t degenerate;  // pairs left out, a box had no width or height
+  boost::int64_t underflow[QUANTITIES];
+  boost::int64_t overflow[QUANTITIES];
+  boost::int64_t counts[QUANTITIES][BINS];
+};
+
+// name and [lower, upper] range of each quantity of LocalizationHistogram
+extern const char* const LOCALIZATION_NAMES[LocalizationHistogram::QUANTITIES];
+extern const double LOCALIZATION_RANGE[LocalizationHistogram::QUANTITIES][2];
+
+/**LocalizationQuantile********************************************************\
+|   Description: Value of a quantity at quantile q, interpolated linearly      |
+|                inside the bin holding it                                     |
+|   Input:                                                                     |
+|     histogram: histograms of the matched pairs                               |
+|     quantity: quantity to read                                               |
+|     q: quantile in [0, 1]                                                    |
+|   Output: value at the quantile, 0 without pairs, -inf (+inf) if it lies    |
+|           below (above) the range of the quantity                            |
+\******************************************************************************/
+double LocalizationQuantile(
+  const LocalizationHistogram&      histogram,
+  LocalizationHistogram::Quantity   quantity,
+  double                            q
+);
+
+/**WriteLocalization***********************************************************\
+|   Description: Write the histograms as csv, one row per label and quantity   |
+|                followed by rows for every label together (label *)           |
+|                (label,quantity,pairs,degenerate,range_lo,range_hi,underflow, |
+|                overflow,p05,p25,p50,p75,p95,bin_0,...)                       |
+|                Bin i covers range_lo + i*(range_hi - range_lo)/BINS up to    |
+|                the next bin, the last bin includes range_hi.  Quantiles      |
+|                outside the range are written as <range_lo or >range_hi.      |
+|   Input:                                                                     |
+|     filename: file to write                                                  |
+|     labels: name of each label                                               |
+|     histograms: histograms of each label                                     |
+|   Output: false if the file could not be written                             |
+\******************************************************************************/
+bool WriteLocalization(
+  const boost::filesystem::path&            filename,
+  const std::vector<std::string>&           labels,
+  const std::vector<LocalizationHistogram>& histograms
+);
+
+/**CounterRandom***************************************************************\
+|   Description: Random 64 bit value for a counter (SplitMix64 finalizer).     |
+|                The same key always gives the same value so any draw can be   |
+|                made independently of every other one.                        |
+\******************************************************************************/
+inline boost::uint64_t CounterRandom( boost::uint64_t key )
+{
+  key += 0x9E3779B97F4A7C15ULL;
+  key = ( key ^ ( key >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+  key = ( key ^ ( key >> 27 ) ) * 0x94D049BB133111EBULL;
+  return key ^ ( key >> 31 );
+}
+
+/**BootstrapMetrics************************************************************\
+|   Description: Confidence intervals for the detection rate, precision and    |
+|                false positives per image from image level bootstrap          |
+|                resamples                                                     |
+|   Input:                                                                     |
+|     counts: counts of every image                                            |
+|     samples: number of resamples                                             |
+|     level: confidence level of the intervals (e.g. 0.95)                     |
+|     seed: generator seed                                                     |
+|     num_threads: number of threads to spread the resamples over              |
+|   Output:                                                                    |
+|     result: statistics with their intervals                                  |
+\******************************************************************************/
+void BootstrapMetrics(
+  const std::vector<ImageCounts>& counts,
+  int                             samples,
+  double                          level,
+  boost::uint64_t                 seed,
+  int                             num_threads,
+  BootstrapResult&                result
+);
+
+/**PairedPermutationTest*******************************************************\
+|   Description: Two sided p-value of the sum of per-image differences         |
+|                between two runs.  Each permutation flips the sign of every   |
+|                difference at random (swapping the runs of that image) and    |
+|                counts sums at least as far from zero as the observed one.    |
+|   Input:                                                                     |
+|     differences: per-image difference (run B - run A)                        |
+|     samples: number of permutations                                          |
+|     seed: generator seed                                                     |
+|     num_threads: number of threads to spread the permutations over           |
+|   Output: (1 + extreme permutations) / (1 + samples), 1 for no samples       |
+\******************************************************************************/
+double PairedPermutationTest(
+  const std::vector<boost::int32_t>&  differences,
+  int                                 samples,
+  boost::uint64_t                     seed,
+  int                                 num_threads
+);
+
+#endif // ANALYSIS_METRICS
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <sstream>
 #include "options.h"
 
 // namespace aliasing
@@ -39,7 +41,20 @@ void LoadSettings(int argc, char *argv[],
   std::string computed_roi_path;
   std::string true_roi_path;
   std::string output_results_path;
+  std::string match_dump_path;
+  std::string pr_curve_path;
+  std::string localization_path;
+  std::string compare_roi_path;
+  std::string compare_results_path;
   std::string draw_results_folder;
+  std::string gallery_folder;
+  std::string image_cache_folder;
+
+  // output of draw_results (image, svg or json)
+  std::string draw_format;
+
+  // list of size bucket bounds
+  std::string size_buckets;
   
   // path to the settings file (obtained from command line)
   std::string config_path;
@@ -86,9 +101,30 @@ void LoadSettings(int argc, char *argv[],
     ("output_results_path", po::value<std::string>
         (&output_results_path),
         "Results output file")
+    ("match_dump_path", po::value<std::string>
+        (&match_dump_path),
+        "Binary file of every scored region pair (empty for none)")
+    ("pr_curve_path", po::value<std::string>
+        (&pr_curve_path),
+        "Precision-recall curve csv file (empty for none)")
+    ("localization_path", po::value<std::string>
+        (&localization_path),
+        "Localization histograms csv file (empty for none)")
+    ("compare_roi_path", po::value<std::string>
+        (&compare_roi_path),
+        "Computed regions of a second run to compare against (empty for none)")
+    ("compare_results_path", po::value<std::string>
+        (&compare_results_path),
+        "Per-image comparison csv file (empty for none)")
     ("draw_results_folder", po::value<std::string>
         (&draw_results_folder),
         "File location to draw results")
+    ("gallery_folder", po::value<std::string>
+        (&gallery_folder),
+        "Folder for the FP/FN chip mosaics (empty for none)")
+    ("image_cache_folder", po::value<std::string>
+        (&image_cache_folder),
+        "Folder of decoded images kept between runs (empty for none)")
     
     // other settings
     ("match_level,M", po::value<int>
@@ -98,9 +134,54 @@ void LoadSettings(int argc, char *argv[],
     ("overlap_threshold,ot", po::value<double>
         (&settings.overlap_threshold)->default_value(0.0),
         "Minimum overlap score")
+    ("num_threads,j", po::value<int>
+        (&settings.num_threads)->default_value(0),
+        "Number of worker threads (0 uses one per core)")
+    ("bootstrap_samples,B", po::value<int>
+        (&settings.bootstrap_samples)->default_value(0),
+        "Bootstrap resamples for confidence intervals (0 for none)")
+    ("confidence_level", po::value<double>
+        (&settings.confidence_level)->default_value(0.95),
+        "Confidence level of the bootstrap intervals")
+    ("bootstrap_seed", po::value<unsigned int>
+        (&settings.bootstrap_seed)->default_value(0),
+        "Seed of the bootstrap resampling")
+    ("compare_top", po::value<int>
+        (&settings.compare_top)->default_value(10),
+        "Number of images with the largest regressions to list")
+    ("permutation_samples", po::value<int>
+        (&settings.permutation_samples)->default_value(10000),
+        "Permutations of the paired significance test (0 for none)")
+    ("size_buckets", po::value<std::string>
+        (&size_buckets),
+        "Lower bounding box area of each size bucket (empty for none)")
     ("draw_results,D", po::value<bool>
         (&settings.draw_results)->default_value(false),
         "Option to draw results and save images")
+    ("draw_format", po::value<std::string>
+        (&draw_format)->default_value("image"),
+        "Draw results as images or as svg/json overlays (image, svg, json)")
+    ("draw_scale", po::value<int>
+        (&settings.draw_scale)->default_value(1),
+        "Draw results on images reduced by this factor (1, 2, 4 or 8)")
+    ("draw_quality", po::value<int>
+        (&settings.draw_quality)->default_value(95),
+        "JPEG quality of the drawn results (0-100)")
+    ("gallery_chip_size", po::value<int>
+        (&settings.gallery_chip_size)->default_value(128),
+        "Size of a square gallery chip in pixels")
+    ("gallery_grid", po::value<int>
+        (&settings.gallery_grid)->default_value(8),
+        "Chips along each side of a gallery sheet")
+    ("gallery_padding", po::value<double>
+        (&settings.gallery_padding)->default_value(0.25),
+        "Padding around a gallery chip as a fraction of the region size")
+    ("image_cache_memory_mb", po::value<int>
+        (&settings.image_cache_memory_mb)->default_value(1024),
+        "Megabytes of decoded images kept in memory")
+    ("image_cache_disk_mb", po::value<int>
+        (&settings.image_cache_disk_mb)->default_value(8192),
+        "Megabytes of decoded images kept in image_cache_folder")
 //    ("calculate_score_range", po::value<bool>
 //        (&settings.calculate_score_range)->default_value(false),
 //        "Causes associated score value to be used")
@@ -202,16 +283,79 @@ void LoadSettings(int argc, char *argv[],
               replace_string,
               output_results_path);
   
+  FindReplace(match_dump_path,
+              "%s",
+              replace_string,
+              match_dump_path);
+  
+  FindReplace(pr_curve_path,
+              "%s",
+              replace_string,
+              pr_curve_path);
+  
+  FindReplace(localization_path,
+              "%s",
+              replace_string,
+              localization_path);
+  
+  FindReplace(compare_roi_path,
+              "%s",
+              replace_string,
+              compare_roi_path);
+  
+  FindReplace(compare_results_path,
+              "%s",
+              replace_string,
+              compare_results_path);
+  
   FindReplace(draw_results_folder,
               "%s",
               replace_string,
               draw_results_folder);
+  
+  FindReplace(gallery_folder,
+              "%s",
+              replace_string,
+              gallery_folder);
+  
+  FindReplace(image_cache_folder,
+              "%s",
+              replace_string,
+              image_cache_folder);
 
   // assign settings fs::path objects using string path values
   settings.computed_roi_path   = fs::path(computed_roi_path);
   settings.true_roi_path       = fs::path(true_roi_path);
   settings.output_results_path = fs::path(output_results_path);
+  settings.match_dump_path     = fs::path(match_dump_path);
+  settings.pr_curve_path       = fs::path(pr_curve_path);
+  settings.localization_path   = fs::path(localization_path);
+  settings.compare_roi_path    = fs::path(compare_roi_path);
+  settings.compare_results_path = fs::path(compare_results_path);
   settings.draw_results_folder = fs::path(draw_results_folder);
+  settings.gallery_folder      = fs::path(gallery_folder);
+  settings.image_cache_folder  = fs::path(image_cache_folder);
+
+  if ( draw_format == "image" )
+    settings.draw_format = Settings::DRAW_IMAGE;
+  else if ( draw_format == "svg" )
+    settings.draw_format = Settings::DRAW_SVG;
+  else if ( draw_format == "json" )
+    settings.draw_format = Settings::DRAW_JSON;
+  else
+  {
+    std::cout << "Error: Unknown draw_format \"" << draw_format
+              << "\" (image, svg or json)" << std::endl;
+    exit(0);
+  }
+
+  // size bucket bounds in ascending order
+  settings.size_buckets.clear();
+  std::istringstream sin(size_buckets);
+  double bound;
+  while ( sin >> bound )
+    settings.size_buckets.push_back(bound);
+  std::sort(settings.size_buckets.begin(), settings.size_buckets.end());
 }
 
 void PrintSettings( const Settings& settings, std::ostream& out )
@@ -223,8 +367,27 @@ void PrintSettings( const Settings& settings, std::ostream& out )
       << "computed_roi_path   = " << settings.computed_roi_path   << std::endl
       << "true_roi_path       = " << settings.true_roi_path       << std::endl
       << "output_results_path = " << settings.output_results_path << std::endl
+      << "match_dump_path     = " << settings.match_dump_path     << std::endl
+      << "pr_curve_path       = " << settings.pr_curve_path       << std::endl
+      << "localization_path   = " << settings.localization_path   << std::endl
+      << "compare_roi_path    = " << settings.compare_roi_path    << std::endl
+      << "compare_results_path = " << settings.compare_results_path
+                                                                  << std::endl
       << "draw_results_folder = " << settings.draw_results_folder << std::endl
       << "draw_results        = " << settings.draw_results        << std::endl
+      << "draw_format         = " <<
+        (settings.draw_format == s::DRAW_SVG  ? "svg"  :
+        (settings.draw_format == s::DRAW_JSON ? "json" : "image")) << std::endl
+      << "draw_scale          = " << settings.draw_scale          << std::endl
+      << "draw_quality        = " << settings.draw_quality        << std::endl
+      << "gallery_folder      = " << settings.gallery_folder      << std::endl
+      << "gallery_chip_size   = " << settings.gallery_chip_size   << std::endl
+      << "gallery_grid        = " << settings.gallery_grid        << std::endl
+      << "gallery_padding     = " << settings.gallery_padding     << std::endl
+      << "image_cache_folder  = " << settings.image_cache_folder  << std::endl
+      << "image_cache_memory_mb = " << settings.image_cache_memory_mb
+                                                                  << std::endl
+      << "image_cache_disk_mb = " << settings.image_cache_disk_mb << std::endl
       << "overlap_threshold   = " << settings.overlap_threshold   << std::endl
       << "match_level         = " << static_cast<int>(settings.match_level) <<
         (settings.match_level == s::NON_EXCLUSIVE    ?"\t\t# NON_EXCLUSIVE"   :
@@ -232,7 +395,16 @@ void PrintSettings( const Settings& settings, std::ostream& out )
         (settings.match_level == s::SEMI_EXCLUSIVE_2 ?"\t\t# SEMI_EXCLUSIVE_2":
         (settings.match_level == s::EXCLUSIVE        ?"\t\t# EXCLUSIVE "      :
         "" )))) << std::endl
-  ;
+      << "num_threads         = " << settings.num_threads         << std::endl
+      << "bootstrap_samples   = " << settings.bootstrap_samples   << std::endl
+      << "confidence_level    = " << settings.confidence_level    << std::endl
+      << "bootstrap_seed      = " << settings.bootstrap_seed      << std::endl
+      << "compare_top         = " << settings.compare_top         << std::endl
+      << "permutation_samples = " << settings.permutation_samples << std::endl
+      << "size_buckets        =";
+  for ( size_t i = 0; i < settings.size_buckets.size(); ++i )
+    out << ' ' << settings.size_buckets[i];
+  out << std::endl;
 }
 
 // overloaded extraction operator
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 
@@ -24,13 +25,41 @@ struct Settings
     EXCLUSIVE        = 4
   } MatchType;
 
+  typedef enum {
+    DRAW_IMAGE = 0,   // annotated copies of the images
+    DRAW_SVG   = 1,   // svg overlay of each image
+    DRAW_JSON  = 2    // json overlay of each image
+  } DrawFormat;
+
   boost::filesystem::path computed_roi_path;
   boost::filesystem::path true_roi_path;
   boost::filesystem::path output_results_path;
+  boost::filesystem::path match_dump_path;
+  boost::filesystem::path pr_curve_path;
+  boost::filesystem::path localization_path;
+  boost::filesystem::path compare_roi_path;
+  boost::filesystem::path compare_results_path;
   boost::filesystem::path draw_results_folder;
+  boost::filesystem::path gallery_folder;
+  boost::filesystem::path image_cache_folder;
   bool draw_results;
+  DrawFormat draw_format;
+  int draw_scale;
+  int draw_quality;
+  int gallery_chip_size;
+  int gallery_grid;
+  double gallery_padding;
+  int image_cache_memory_mb;
+  int image_cache_disk_mb;
   double overlap_threshold;
   MatchType match_level;
+  int num_threads;
+  int bootstrap_samples;
+  double confidence_level;
+  unsigned int bootstrap_seed;
+  std::vector<double> size_buckets; // lower bounding box area of each bucket
+  int compare_top;
+  int permutation_samples;
 //  bool calculate_score_range;
 //  Range score_range;
   double score_threshold; // XXX: Temporary
@@ -0,0 +1,146 @@
+//
+// Description : Minimal helpers for spreading independent work items over a
+//               group of threads.
+//
+// ParallelFor() hands out indices from a shared atomic counter so workers
+// never block on each other.  Anything a work item needs to write must be
+// owned by that item (or by the calling thread via the thread argument).
+//
+// BoundedQueue connects the stages of a pipeline, producers block while it is
+// full so a fast stage can't run ahead of a slow one by more than the
+// capacity.
+//
+
+#ifndef ANALYSIS_PARALLEL
+#define ANALYSIS_PARALLEL
+
+#include <cstddef>
+#include <deque>
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <boost/utility.hpp>
+
+/**ThreadCount*****************************************************************\
+|   Description: Number of threads to use for a thread count setting, values  |
+|                below one select one thread per hardware core.                |
+\******************************************************************************/
+inline int ThreadCount( int setting )
+{
+  if ( setting > 0 )
+    return setting;
+
+  int cores = static_cast<int>(boost::thread::hardware_concurrency());
+  return cores > 0 ? cores : 1;
+}
+
+// worker loop used by ParallelFor()
+template <typename Body>
+struct ParallelWorker
+{
+  ParallelWorker( boost::atomic<size_t>& next, size_t count, int thread,
+    Body& body ) : _next(next), _count(count), _thread(thread), _body(body) {}
+
+  void operator()()
+  {
+    for ( size_t index = _next++; index < _count; index = _next++ )
+      _body(index, _thread);
+  }
+
+  boost::atomic<size_t>&  _next;
+  size_t                  _count;
+  int                     _thread;
+  Body&                   _body;
+};
+
+/**ParallelFor*****************************************************************\
+|   Description: Calls body(index, thread) once for every index in            |
+|                [0, count) using up to thread_count threads.  thread is in    |
+|                [0, thread_count) and identifies the calling worker so per   |
+|                thread state can be kept in a plain array.                    |
+|   Input:                                                                     |
+|     count: number of work items                                              |
+|     thread_count: number of worker threads                                   |
+|     body: functor with operator()(size_t index, int thread)                  |
+\******************************************************************************/
+template <typename Body>
+void ParallelFor( size_t count, int thread_count, Body& body )
+{
+  boost::atomic<size_t> next(0);
+
+  if ( thread_count > static_cast<int>(count) )
+    thread_count = static_cast<int>(count);
+
+  // no point starting threads for a single worker
+  if ( thread_count <= 1 )
+  {
+    ParallelWorker<Body>(next, count, 0, body)();
+    return;
+  }
+
+  boost::thread_group threads;
+  for ( int thread = 1; thread < thread_count; ++thread )
+    threads.create_thread(ParallelWorker<Body>(next, count, thread, body));
+
+  // the calling thread does its share too
+  ParallelWorker<Body>(next, count, 0, body)();
+
+  threads.join_all();
+}
+
+/**BoundedQueue****************************************************************\
+|   Description: Blocking queue between the stages of a pipeline.  It is       |
+|                closed once every producer has called ProducerDone(), after   |
+|                that Pop() returns false as soon as the queue is empty.       |
+|   Input:                                                                     |
+|     capacity: most items held at once                                        |
+|     producers: number of threads pushing to the queue                        |
+\******************************************************************************/
+template <typename T>
+class BoundedQueue : boost::noncopyable
+{
+  public:
+    BoundedQueue( size_t capacity, int producers ) :
+      _capacity(capacity > 0 ? capacity : 1), _producers(producers) {}
+
+    // waits for space, then adds item
+    void Push( const T& item )
+    {
+      boost::unique_lock<boost::mutex> lock(_mutex);
+      while ( _items.size() >= _capacity )
+        _not_full.wait(lock);
+      _items.push_back(item);
+      _not_empty.notify_one();
+    }
+
+    // waits for an item, false if the queue is closed and empty
+    bool Pop( T& item )
+    {
+      boost::unique_lock<boost::mutex> lock(_mutex);
+      while ( _items.empty() && _producers > 0 )
+        _not_empty.wait(lock);
+      if ( _items.empty() )
+        return false;
+      item = _items.front();
+      _items.pop_front();
+      _not_full.notify_one();
+      return true;
+    }
+
+    // called once by every producer when it has pushed its last item
+    void ProducerDone()
+    {
+      boost::unique_lock<boost::mutex> lock(_mutex);
+      if ( --_producers <= 0 )
+        _not_empty.notify_all();
+    }
+
+  private:
+    std::deque<T>             _items;
+    size_t                    _capacity;
+    int                       _producers;
+    boost::mutex              _mutex;
+    boost::condition_variable _not_full;
+    boost::condition_variable _not_empty;
+};
+
+#endif // ANALYSIS_PARALLEL
@@ -1,45 +1,127 @@
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <unistd.h>
 #include "progress_bar.h"
 
+///////////////////////// LOCAL FUNCTIONS //////////////////////////////////////
+
+// microseconds on a clock that never goes back
+boost::int64_t Microseconds()
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<boost::int64_t>(now.tv_sec) * 1000000 +
+         now.tv_nsec / 1000;
+}
+
+// true if out is a standard stream attached to a terminal
+bool IsTerminal( const ostream& out )
+{
+  if ( &out == &cout )
+    return isatty(STDOUT_FILENO);
+  if ( &out == &cerr || &out == &clog )
+    return isatty(STDERR_FILENO);
+  return false;
+}
+
+// h:mm:ss
+string Duration( double seconds )
+{
+  long total = static_cast<long>(seconds + 0.5);
+  ostringstream text;
+  text << total / 3600 << ':' << setfill('0') << setw(2) << total / 60 % 60
+       << ':' << setw(2) << total % 60;
+  return text.str();
+}
+
+//////////////////////// GLOBAL FUNCTIONS //////////////////////////////////////
+
 ProgressBar::ProgressBar() :
   _out(&cout),
   _maxVal(1),
-  _currentVal(-1),
   _width(10),
-  _preMsg("")
+  _preMsg(""),
+  _enabled(IsTerminal(cout)),
+  _start(Microseconds()),
+  _interval(100000),
+  _count(0),
+  _nextRender(0),
+  _rendering(false),
+  _finished(false)
 {}
 
 ProgressBar::ProgressBar( ostream& out, const string& preMsg, int maxVal,
-  int width ) :
+  int width, double rate ) :
   _out(&out),
   _maxVal(maxVal),
-  _currentVal(-1),
   _width(width),
-  _preMsg(preMsg)
+  _preMsg(preMsg),
+  _enabled(IsTerminal(out)),
+  _start(Microseconds()),
+  _interval(rate > 0.0 ? static_cast<boost::int64_t>(1000000 / rate) : 0),
+  _count(0),
+  _nextRender(0),
+  _rendering(false),
+  _finished(false)
 {}
 
 void ProgressBar::update( const int& currentVal )
 {
-  if ( (int)(_width * ((float)currentVal / _maxVal)) == _currentVal
-     && currentVal < _maxVal-1 )
+  _count.store(currentVal, boost::memory_order_relaxed);
+  render(false);
+}
+
+void ProgressBar::add( int count )
+{
+  _count.fetch_add(count, boost::memory_order_relaxed);
+  render(false);
+}
+
+void ProgressBar::finish()
+{
+  render(true);
+}
+
+void ProgressBar::render( bool final )
+{
+  if ( !_enabled || _finished.load(boost::memory_order_relaxed) )
     return;
-  
-  _currentVal = (int)(_width * ((float)currentVal / _maxVal));
 
-  *_out << '\r' << _preMsg << '[';
-  if ( currentVal >= _maxVal-1 && currentVal != -1 )
-  {
-    for ( int i = 0; i < _width; i++ )
-      *_out << '*';
-    *_out << "] Complete!" << endl;
-  }
-  else
+  // cheap checks first so most updates never touch the stream
+  boost::int64_t now = Microseconds();
+  if ( !final && now < _nextRender.load(boost::memory_order_relaxed) )
+    return;
+  if ( _rendering.exchange(true, boost::memory_order_acquire) )
   {
-    for ( int i = 0; i < _width; i++ )
-      *_out << ( i <= _currentVal && currentVal != -1 ? '*' : '-' );
-    *_out << "] "
-         << setw(5) << fixed << right << setprecision(0)
-         << 100.0 * max(0.0,(double)currentVal) / (float)_maxVal << "%  "
-         << '\r' << setprecision(-1) << flush;
+    if ( !final )
+      return;
+
+    // the final line waits for any redraw in progress
+    while ( _rendering.exchange(true, boost::memory_order_acquire) )
+      ;
   }
-}
+  _nextRender.store(now + _interval, boost::memory_order_relaxed);
 
+  int currentVal = _count.load(boost::memory_order_relaxed);
+  double fraction = _maxVal > 0 ?
+    min(1.0, max(0.0, static_cast<double>(currentVal) / _maxVal)) : 1.0;
+  double seconds = ( now - _start ) / 1e6;
+  double rate = seconds > 0.0 ? currentVal / seconds : 0.0;
+  int filled = static_cast<int>(_width * fraction);
+
+  ostringstream line;
+  line << '\r' << _preMsg << '[' << string(filled, '*')
+       << string(_width - filled, '-') << "] " << setw(3)
+       << static_cast<int>(100.0 * fraction) << "%  " << fixed
+       << setprecision(1) << rate << "/s  ";
+  if ( final || currentVal >= _maxVal )
+    line << Duration(seconds) << "          \n";
+  else if ( rate > 0.0 )
+    line << "ETA " << Duration(( _maxVal - currentVal ) / rate) << "      ";
+  *_out << line.str() << flush;
+
+  if ( final || currentVal >= _maxVal )
+    _finished.store(true, boost::memory_order_relaxed);
+  _rendering.store(false, boost::memory_order_release);
+}
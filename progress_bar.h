@@ -4,10 +4,17 @@
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/utility.hpp>
 
 using namespace std;
 
-class ProgressBar
+// Progress of a stage as a bar with the rate and time left.  Any thread may
+// report finished items, the count is a relaxed atomic and only one caller at
+// a time redraws, at most rate times per second.  Nothing is written unless
+// the stream is std::cout or std::cerr attached to a terminal.
+class ProgressBar : boost::noncopyable
 {
   public:
     ProgressBar();
@@ -15,17 +22,33 @@ class ProgressBar
       ostream& out,
       const string& preMsg = "",
       int maxVaL = 1,
-      int width = 10
+      int width = 10,
+      double rate = 10.0
     );
 
+    // sets the number of finished items
     void update( const int& currentVal );
+
+    // adds to the number of finished items
+    void add( int count = 1 );
+
+    // draws the final count and ends the line
+    void finish();
+
   protected:
+    void render( bool final );
+
     ostream* _out;
     int _maxVal;
-    int _currentVal;
     int _width;
     string _preMsg;
+    bool _enabled;                      // stream is a terminal
+    boost::int64_t _start;              // microseconds, monotonic clock
+    boost::int64_t _interval;           // microseconds between redraws
+    boost::atomic<int> _count;          // finished items
+    boost::atomic<boost::int64_t> _nextRender;  // earliest next redraw
+    boost::atomic<bool> _rendering;     // a thread is redrawing
+    boost::atomic<bool> _finished;
 };
 
 #endif
-